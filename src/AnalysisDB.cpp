@@ -0,0 +1,210 @@
+#include "AnalysisDB.h"
+
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+
+#   ifndef  NOMINMAX
+#       define NOMINMAX // disable macros min() and max()
+#   endif
+#   ifndef  WIN32_LEAN_AND_MEAN
+#       define WIN32_LEAN_AND_MEAN
+#   endif
+
+#   include <windows.h>
+
+#   undef WIN32_LEAN_AND_MEAN
+#   undef NOMINMAX
+
+#else    // Linux - Unix
+
+#   include <sys/stat.h>
+#   include <sys/mman.h>
+#   include <fcntl.h>
+#   include <unistd.h>
+
+#endif
+
+AnalysisDB  ADB; // Global Analysis Database
+
+using namespace std;
+
+const u64 AnalysisDB::MAGIC = U64 (0x31424441204E4F44); // "DON ADB1"
+
+AnalysisDB::AnalysisDB ()
+    : _data (NULL)
+    , _mapping (0)
+    , _header (NULL)
+    , _entries (NULL)
+    , _entries_mask (0)
+{}
+
+AnalysisDB::~AnalysisDB ()
+{
+    close ();
+}
+
+bool AnalysisDB::open (const string &fn_adb, u32 mem_size_mb)
+{
+    close ();
+
+    // Power of 2 number of entries for the new file
+    u64 entries = TOT_CLUSTER_ENTRY;
+    while (2 * entries * sizeof (ADEntry) <= (u64 (mem_size_mb) << 20))
+    {
+        entries *= 2;
+    }
+    u64 new_size = sizeof (ADHeader) + entries * sizeof (ADEntry);
+
+#ifndef _WIN32
+
+    i32 fd = ::open (fn_adb.c_str (), O_RDWR|O_CREAT, 0644);
+    if (fd < 0) return false;
+
+    struct stat statbuf;
+    fstat (fd, &statbuf);
+    u64 size = statbuf.st_size;
+    if (size == 0)
+    {
+        size = new_size;
+        if (ftruncate (fd, size) != 0)
+        {
+            ::close (fd);
+            return false;
+        }
+    }
+
+    char *data = (char *) mmap (NULL, size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close (fd);
+    if (data == (char *) (-1)) return false;
+
+    _mapping = size;
+
+#else
+
+    HANDLE fd = CreateFile (fn_adb.c_str (), GENERIC_READ|GENERIC_WRITE, FILE_SHARE_READ, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (fd == INVALID_HANDLE_VALUE) return false;
+
+    DWORD size_low, size_high;
+    size_low = GetFileSize (fd, &size_high);
+    u64 size = (u64 (size_high) << 32) | u64 (size_low);
+    if (size == 0)
+    {
+        size = new_size;
+        size_high = DWORD (size >> 32);
+        size_low  = DWORD (size);
+    }
+
+    HANDLE map = CreateFileMapping (fd, NULL, PAGE_READWRITE, size_high, size_low, NULL);
+    CloseHandle (fd);
+    if (map == NULL) return false;
+
+    char *data = (char *) MapViewOfFile (map, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    if (data == NULL)
+    {
+        CloseHandle (map);
+        return false;
+    }
+
+    _mapping = u64 (map);
+
+#endif
+
+    _data      = data;
+    _header    = (ADHeader *) (data);
+    _entries   = (ADEntry  *) (data + sizeof (ADHeader));
+    _fn_adb    = fn_adb;
+
+    if (size == new_size && _header->magic == 0)
+    {
+        // New file, mapping is zero-filled
+        _header->magic      = MAGIC;
+        _header->entries    = entries;
+        _header->entry_size = sizeof (ADEntry);
+    }
+
+    if (   _header->magic      != MAGIC
+        || _header->entry_size != sizeof (ADEntry)
+        || _header->entries < TOT_CLUSTER_ENTRY
+        || (_header->entries & (_header->entries - 1)) != 0
+        || sizeof (ADHeader) + _header->entries * sizeof (ADEntry) != size)
+    {
+        cerr << "ERROR: Analysis Database \'" << fn_adb << "\' is not valid..." << endl;
+        close ();
+        return false;
+    }
+
+    _entries_mask = _header->entries - TOT_CLUSTER_ENTRY;
+    return true;
+}
+
+void AnalysisDB::close ()
+{
+    if (_data == NULL) return;
+
+#ifndef _WIN32
+    munmap (_data, _mapping);
+#else
+    UnmapViewOfFile (_data);
+    CloseHandle ((HANDLE) _mapping);
+#endif
+
+    _data         = NULL;
+    _mapping      = 0;
+    _header       = NULL;
+    _entries      = NULL;
+    _entries_mask = 0;
+}
+
+const AnalysisDB::ADEntry* AnalysisDB::probe (Key key) const
+{
+    if (_data == NULL) return NULL;
+
+    const ADEntry *ade = _entries + (key & _entries_mask);
+    for (u08 i = 0; i < TOT_CLUSTER_ENTRY; ++i, ++ade)
+    {
+        if (ade->key == key && ade->move != MOVE_NONE)
+        {
+            return ade;
+        }
+    }
+    return NULL;
+}
+
+void AnalysisDB::store (Key key, Move move, Value value, u08 depth, u64 nodes)
+{
+    if (_data == NULL || move == MOVE_NONE) return;
+
+    ADEntry *ade = _entries + (key & _entries_mask);
+    ADEntry *rde = ade;
+    for (u08 i = 0; i < TOT_CLUSTER_ENTRY; ++i, ++ade)
+    {
+        if (ade->key == key || ade->move == MOVE_NONE)
+        {
+            rde = ade;
+            break;
+        }
+        // Replace the shallowest entry
+        if (ade->depth < rde->depth)
+        {
+            rde = ade;
+        }
+    }
+
+    if (rde->move != MOVE_NONE)
+    {
+        // Keep the deeper result
+        if (rde->depth > depth) return;
+    }
+    else
+    {
+        ++_header->stored;
+    }
+
+    rde->key   = key;
+    rde->nodes = nodes;
+    rde->move  = u16 (move);
+    rde->value = i16 (value);
+    rde->depth = depth;
+}
@@ -0,0 +1,92 @@
+#ifdef _MSC_VER
+#   pragma once
+#endif
+
+#ifndef _ANALYSIS_DB_H_INC_
+#define _ANALYSIS_DB_H_INC_
+
+#include <string>
+
+#include "Type.h"
+#include "noncopyable.h"
+
+// An Analysis Database keeps the results of completed searches on disk,
+// so the work is not lost between sessions as it is with the TT.
+// The file is a header followed by a power of 2 number of entries,
+// hashed by the position key in clusters of TOT_CLUSTER_ENTRY entries.
+// The file is memory-mapped, a probe is a lookup in a single cluster
+// and a store writes straight into the mapping (the OS flushes it to disk).
+// Analysis Database file has *.adb extension
+class AnalysisDB
+    : public std::noncopyable
+{
+
+public:
+
+    // Analysis Database entry needs 24 bytes to be stored.
+    //  - Key       8 bytes
+    //  - Nodes     8 bytes
+    //  - Move      2 bytes
+    //  - Value     2 bytes (from side to move point of view, mate relative to the position)
+    //  - Depth     1 byte
+    //  - Padding   3 bytes
+    struct ADEntry
+    {
+        u64 key;
+        u64 nodes;
+        u16 move;
+        i16 value;
+        u08 depth;
+        u08 pad[3];
+    };
+
+    struct ADHeader
+    {
+        u64 magic;
+        u64 entries;
+        u32 entry_size;
+        u32 pad;
+        u64 stored;
+    };
+
+    static const u64 MAGIC;
+    static const u08 TOT_CLUSTER_ENTRY = 4;
+
+private:
+
+    std::string _fn_adb;
+
+    char     *_data;
+    u64       _mapping;
+
+    ADHeader *_header;
+    ADEntry  *_entries;
+    u64       _entries_mask;
+
+public:
+
+    AnalysisDB ();
+   ~AnalysisDB ();
+
+    // open() maps the database file, creates it with mem_size_mb if it does not exist.
+    bool open (const std::string &fn_adb, u32 mem_size_mb);
+    void close ();
+
+    bool is_open () const { return _data != NULL; }
+
+    std::string filename () const { return _fn_adb; }
+
+    u64 entries () const { return is_open () ? _header->entries : 0; }
+    u64 stored  () const { return is_open () ? _header->stored  : 0; }
+
+    // probe() looks up the entry of the position, NULL if not found.
+    const ADEntry* probe (Key key) const;
+
+    // store() writes the entry of the position, it keeps the deeper result.
+    void store (Key key, Move move, Value value, u08 depth, u64 nodes);
+
+};
+
+extern AnalysisDB ADB; // Global Analysis Database
+
+#endif // _ANALYSIS_DB_H_INC_
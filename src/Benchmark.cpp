@@ -1,20 +1,36 @@
 #include "Benchmark.h"
 
 #include <iostream>
+#include <iomanip>
 #include <fstream>
+#include <sstream>
+#include <algorithm>
 #include <vector>
+#include <cstring>
+#include <cstdio>
 
+#include "BitBoard.h"
+#include "BitScan.h"
+#include "RKISS.h"
 #include "Position.h"
+#include "PositionStream.h"
+#include "MoveGenerator.h"
+#include "MovePicker.h"
 #include "Searcher.h"
 #include "Transposition.h"
 #include "Thread.h"
 #include "UCI.h"
 #include "Debugger.h"
+#include "Evaluator.h"
+#include "Material.h"
+#include "Endgame.h"
 
 using namespace std;
 using namespace Searcher;
 using namespace Time;
 using namespace Threads;
+using namespace BitBoard;
+using namespace MoveGenerator;
 
 namespace {
 
@@ -54,124 +70,1521 @@ namespace {
         "8/3p3B/5p2/5P2/p7/PP5b/k7/6K1 w - - 0 30"
     };
 
-}
+    // Positions of the endgames with a specialized evaluation or scaling function,
+    // the strong side is white and no side is in check.
+    const u08   ENDGAME_TOTAL = 22;
 
-// benchmark () runs a simple benchmark by letting engine analyze a set of positions for a given limit each.
-// There are five optional parameters:
-//  - transposition table size (default is 32 MB).
-//  - number of search threads that should be used (default is 1 thread).
-//  - limit value spent for each position (default is 13 depth),
-//  - type of the limit value:
-//     * 'depth' (default).
-//     * 'time' in secs
-//     * 'nodes' to search.
-//     * 'mate' in moves
-//  - filename where to look for positions in fen format (defaults are the positions defined above)
-//     * 'default' for builtin position
-//     * 'current' for current position
-//     * '<filename>' containing fens position
-// example: bench 32 1 10 depth default
-void benchmark (istream &is, const Position &pos)
-{
-    string token;
-    vector<string> fens;
+    const char* EndgameFens[ENDGAME_TOTAL][2] =
+    {
+        { "KPK"    , "8/8/8/4k3/8/8/4P3/4K3 w - - 0 1" },
+        { "KNNK"   , "8/8/8/4k3/8/8/8/2NNK3 w - - 0 1" },
+        { "KBNK"   , "8/8/8/4k3/8/8/8/2BNK3 w - - 0 1" },
+        { "KRKP"   , "8/8/8/4k3/8/2p5/8/R3K3 w - - 0 1" },
+        { "KRKB"   , "8/8/2b5/4k3/8/8/8/R3K3 w - - 0 1" },
+        { "KRKN"   , "8/8/2n5/4k3/8/8/8/R3K3 w - - 0 1" },
+        { "KQKP"   , "8/8/8/4k3/8/8/Q1p5/4K3 w - - 0 1" },
+        { "KQKR"   , "8/8/2r5/4k3/8/8/Q7/4K3 w - - 0 1" },
+        { "KBBKN"  , "8/8/2n5/4k3/8/8/8/1BB1K3 w - - 0 1" },
+        { "KNPK"   , "8/8/8/4k3/8/8/1P6/1N2K3 w - - 0 1" },
+        { "KNPKB"  , "8/8/2b5/4k3/8/8/1P6/1N2K3 w - - 0 1" },
+        { "KRPKR"  , "8/8/2r5/4k3/8/8/1P6/R3K3 w - - 0 1" },
+        { "KRPKB"  , "8/8/2b5/4k3/8/8/1P6/R3K3 w - - 0 1" },
+        { "KBPKB"  , "8/8/2b5/4k3/8/8/1P6/2B1K3 w - - 0 1" },
+        { "KBPKN"  , "8/8/2n5/4k3/8/8/1P6/2B1K3 w - - 0 1" },
+        { "KBPPKB" , "8/8/2b5/4k3/8/8/1PP5/2B1K3 w - - 0 1" },
+        { "KRPPKRP", "8/8/2r5/4k1p1/8/8/1PP5/R3K3 w - - 0 1" },
+        { "KXK"    , "8/8/8/4k3/8/8/8/R2QK3 w - - 0 1" },
+        { "KBPsKs" , "8/8/8/4k3/8/8/PP6/2B1K3 w - - 0 1" },
+        { "KQKRPs" , "8/8/2r5/4k3/8/2p5/Q7/4K3 w - - 0 1" },
+        { "KPsK"   , "8/8/8/4k3/8/8/PP6/4K3 w - - 0 1" },
+        { "KPKP"   , "8/4p3/8/4k3/8/8/4P3/4K3 w - - 0 1" },
+    };
+
+    // Positions of the perft suite with their number of leaf nodes at depth 4,
+    // full of the tricky cases (castling, en-passant, promotions, pins and checks).
+    const u08   PERFT_TOTAL = 6;
+
+    const char* PerftFens[PERFT_TOTAL] =
+    {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+        "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPP1/R4RK1 w - - 0 10",
+    };
+
+    const u64   PerftLeafs[PERFT_TOTAL] =
+    {
+        U64 (197281), U64 (4085603), U64 (43238), U64 (422333), U64 (2103487), U64 (3900101),
+    };
+
+    // Endgames where neither side can make progress (blocked pawns, opposite bishops),
+    // searched after a long shuffle of reversible moves by the repetitions benchmark.
+    const u08   FORTRESS_TOTAL = 4;
+
+    const char* FortressFens[FORTRESS_TOTAL] =
+    {
+        "8/5k2/8/3p4/3P4/2K5/8/8 w - - 0 50",
+        "8/8/1k6/p1p5/P1P5/1K6/8/8 w - - 0 50",
+        "6k1/5p2/6p1/8/5P2/4B1P1/5K2/2b5 w - - 0 50",
+        "8/1k6/8/1p1p1p2/1P1P1P2/2B5/3K4/5b2 w - - 0 50",
+    };
+
+    // Sliders of one type of one side, with the occupancy their attacks are computed on
+    struct SliderSet
+    {
+        PieceT   pt;
+        Bitboard occ;
+        Square   sqs[16 + 1];
+    };
+
+    // sliders_walk() collects the slider sets of all the nodes of the tree up to the depth
+    // (in plies), with the occupancies used by the evaluation (x-rays through own sliders).
+    void sliders_walk (Position &pos, u08 depth, vector<SliderSet> &sets)
+    {
+        for (Color c = WHITE; c <= BLACK; ++c)
+        {
+            for (PieceT pt = BSHP; pt <= QUEN; ++pt)
+            {
+                if (pos.count (c, pt) == 0) continue;
+
+                SliderSet set;
+                set.pt  = pt;
+                set.occ = (BSHP == pt) ? pos.pieces () ^ pos.pieces (c, QUEN, BSHP)
+                        : (ROOK == pt) ? pos.pieces () ^ pos.pieces (c, QUEN, ROOK)
+                        :                pos.pieces ();
+                const Square *pl = pos[c|pt];
+                u08 n = 0;
+                while ((set.sqs[n] = pl[n]) != SQ_NO) ++n;
+                sets.push_back (set);
+            }
+        }
+        if (depth == 0) return;
+
+        StateInfo si;
+        for (MoveList<LEGAL> itr (pos); *itr != MOVE_NONE; ++itr)
+        {
+            pos.do_move (*itr, si);
+            sliders_walk (pos, depth - 1, sets);
+            pos.undo_move ();
+        }
+    }
+
+    // sliders_sum() sums the attacks of the slider sets, either looked up
+    // square by square or filled set by set.
+    template<bool FILL>
+    u64 sliders_sum (const vector<SliderSet> &sets)
+    {
+        u64 sum = 0;
+        for (vector<SliderSet>::const_iterator itr = sets.begin (); itr != sets.end (); ++itr)
+        {
+            if (FILL)
+            {
+                Bitboard attacks[16];
+                u08 n = (BSHP == itr->pt) ? slider_attacks<BSHP> (itr->sqs, itr->occ, attacks)
+                      : (ROOK == itr->pt) ? slider_attacks<ROOK> (itr->sqs, itr->occ, attacks)
+                      :                     slider_attacks<QUEN> (itr->sqs, itr->occ, attacks);
+                for (u08 i = 0; i < n; ++i) sum += attacks[i];
+            }
+            else
+            {
+                const Square *pl = itr->sqs;
+                Square s;
+                while ((s = *pl++) != SQ_NO)
+                {
+                    sum += (BSHP == itr->pt) ? attacks_bb<BSHP> (s, itr->occ)
+                         : (ROOK == itr->pt) ? attacks_bb<ROOK> (s, itr->occ)
+                         :                     attacks_bb<QUEN> (s, itr->occ);
+                }
+            }
+        }
+        return sum;
+    }
+
+    // One slider attack lookup
+    struct SliderSample
+    {
+        Bitboard occ;
+        Square   s;
+        PieceT   pt;
+    };
+
+    typedef Bitboard (*SliderAttacks) (Square s, Bitboard occ);
+
+    // Slider attack engine under test, with its bishop, rook and queen attacks
+    struct SliderEngine
+    {
+        const char   *name;
+        SliderAttacks attacks[3];
+        u32         (*table_size) ();
+    };
+
+    template<PieceT PT>
+    Bitboard magic_attacks (Square s, Bitboard occ)
+    {
+        return (BSHP == PT) ? magic_attacks_bb<BSHP> (s, occ)
+             : (ROOK == PT) ? magic_attacks_bb<ROOK> (s, occ)
+             : magic_attacks_bb<BSHP> (s, occ) | magic_attacks_bb<ROOK> (s, occ);
+    }
+
+    template<PieceT PT>
+    Bitboard fill_attacks (Square s, Bitboard occ)
+    {
+        const Square sqs[2] = { s, SQ_NO };
+        Bitboard attacks = U64 (0);
+        slider_attacks<PT> (sqs, occ, &attacks);
+        return attacks;
+    }
+
+    u32 no_table_size () { return 0; }
 
-    // Assign default values to missing arguments
-    string hash       = (is >> token) ? token : "32";
-    string threads    = (is >> token) ? token : "1";
-    string limit_val  = (is >> token) ? token : "13";
-    string limit_type = (is >> token) ? token : "depth";
-    string fen_fn     = (is >> token) ? token : "default";
+    Bitboard no_attacks (Square, Bitboard) { return U64 (0); }
 
-    *Options["Hash"]    = hash;
-    *Options["Threads"] = threads;
+    const SliderEngine SliderEngines[] =
+    {
+#ifdef BMI2
+        { "PEXT"        , { magic_attacks<BSHP>, magic_attacks<ROOK>, magic_attacks<QUEN> }, magic_table_size },
+#else
+        { "Magic"       , { magic_attacks<BSHP>, magic_attacks<ROOK>, magic_attacks<QUEN> }, magic_table_size },
+#endif
+        { "Kindergarten", { Kindergarten::attacks_bb<BSHP>, Kindergarten::attacks_bb<ROOK>, Kindergarten::attacks_bb<QUEN> }, Kindergarten::table_size },
+        { "Sherwin"     , { Sherwin::attacks_bb<BSHP>, Sherwin::attacks_bb<ROOK>, Sherwin::attacks_bb<QUEN> }, Sherwin::table_size },
+        { "Fills"       , { fill_attacks<BSHP>, fill_attacks<ROOK>, fill_attacks<QUEN> }, no_table_size },
+    };
+
+    const u08 SLIDER_ENGINES = sizeof (SliderEngines) / sizeof (*SliderEngines);
+
+    // Ring buffer streamed between the lookups to evict the tables from L1/L2,
+    // much larger than the L2 and read sequentially so that the stream itself is cheap.
+    const u32 STREAM_SIZE = 8 * 1024 * 1024;
 
-    TT.master_clear ();
+    // sliders_time() returns the time (in ms) of the lookups of the samples,
+    // streaming one cache line of the buffer per lookup if a buffer is given.
+    point sliders_time (const SliderEngine &engine, const vector<SliderSample> &samples, u32 passes, const u08 *stream, u64 &sum)
+    {
+        u32 offset = 0;
+        point elapsed = now ();
+        for (u32 n = 0; n < passes; ++n)
+        {
+            for (vector<SliderSample>::const_iterator itr = samples.begin (); itr != samples.end (); ++itr)
+            {
+                sum += engine.attacks[itr->pt - BSHP] (itr->s, itr->occ);
+                if (stream != NULL)
+                {
+                    sum += stream[offset];
+                    offset = (offset + 64) % STREAM_SIZE;
+                }
+            }
+        }
+        return now () - elapsed;
+    }
 
-    i32     value = abs (atoi (limit_val.c_str ()));
-    //value = value >= 0 ? value : -value;
+    // generate_filtered() generates all the legal moves the way it was done before
+    // the legal generator: pseudo-legal moves filtered with Position::legal().
+    ValMove* generate_filtered (ValMove *moves, const Position &pos)
+    {
+        ValMove *end = pos.checkers ()
+            ? generate<EVASION> (moves, pos)
+            : generate<RELAX  > (moves, pos);
 
-    LimitsT limits;
-    if      (limit_type == "time")  limits.movetime = value * M_SEC; // movetime is in ms
-    else if (limit_type == "nodes") limits.nodes    = value;
-    else if (limit_type == "mate")  limits.mate     = value;
-    //else if (limit_type == "depth")
-    else                            limits.depth    = value;
+        Square   king_sq = pos.king_sq (pos.active ());
+        Bitboard pinneds = pos.pinneds (pos.active ());
 
-    StateInfoStackPtr states;
+        ValMove *cur = moves;
+        while (cur != end)
+        {
+            Move m = cur->move;
+            if (  ((org_sq (m) == king_sq) || pinneds != U64 (0) || ENPASSANT == mtype (m))
+                && !pos.legal (m, pinneds))
+            {
+                cur->move = (--end)->move;
+            }
+            else
+            {
+                ++cur;
+            }
+        }
+        return end;
+    }
 
-    if      (fen_fn == "default")
+    // perft_walk() counts the leaf nodes of the tree up to the depth (in plies),
+    // the moves of the last ply are only generated and counted, as perft does.
+    template<bool FILTERED>
+    u64 perft_walk (Position &pos, u08 depth)
     {
-        fens.assign (DefaultFens, DefaultFens + FEN_TOTAL);
-        states = StateInfoStackPtr (new StateInfoStack ());
+        ValMove moves[MAX_MOVES];
+        ValMove *end = FILTERED ? generate_filtered (moves, pos) : generate<LEGAL> (moves, pos);
+        if (depth <= 1) return u64 (end - moves);
+
+        u64 leafs = 0;
+        StateInfo si;
+        for (ValMove *cur = moves; cur != end; ++cur)
+        {
+            pos.do_move (cur->move, si);
+            leafs += perft_walk<FILTERED> (pos, depth - 1);
+            pos.undo_move ();
+        }
+        return leafs;
     }
-    else if (fen_fn == "current")
+
+    // make_walk() makes all the moves of the tree up to the depth (in plies) and counts
+    // the leaf nodes as made, either with do-undo on the position or with copy-make on
+    // the positions of the plies (the position of the ply is plies[0]).
+    template<bool COPY>
+    u64 make_walk (Position &pos, Position *plies, u08 depth)
     {
-        fens.push_back (pos.fen ());
+        ValMove moves[MAX_MOVES];
+        ValMove *end = generate<LEGAL> (moves, pos);
+
+        u64 leafs = 0;
+        StateInfo si;
+        CheckInfo ci (pos);
+        for (ValMove *cur = moves; cur != end; ++cur)
+        {
+            const CheckInfo *gives_ci = pos.gives_check (cur->move, ci) ? &ci : NULL;
+            if (COPY)
+            {
+                pos.copy_move (cur->move, plies[1], si, gives_ci);
+                leafs += (depth <= 1) ? 1 : make_walk<COPY> (plies[1], plies + 1, depth - 1);
+            }
+            else
+            {
+                pos.do_move (cur->move, si, gives_ci);
+                leafs += (depth <= 1) ? 1 : make_walk<COPY> (pos, plies, depth - 1);
+                pos.undo_move ();
+            }
+        }
+        return leafs;
+    }
+
+    // captures_walk() visits all the nodes of the tree up to the depth (in plies) and
+    // generates the captures of the nodes not in check with the given generator,
+    // counting and summing the moves (the sum does not depend on their order).
+    template<GenT GT>
+    void captures_walk (Position &pos, u08 depth, u64 &count, u64 &sum)
+    {
+        if (pos.checkers () == U64 (0))
+        {
+            ValMove moves[MAX_MOVES];
+            ValMove *end = generate<GT> (moves, pos);
+            count += end - moves;
+            for (ValMove *cur = moves; cur != end; ++cur)
+            {
+                sum += u64 (cur->move) * cur->move;
+            }
+        }
+        if (depth == 0) return;
+
+        StateInfo si;
+        for (MoveList<LEGAL> itr (pos); *itr != MOVE_NONE; ++itr)
+        {
+            pos.do_move (*itr, si);
+            captures_walk<GT> (pos, depth - 1, count, sum);
+            pos.undo_move ();
+        }
     }
-    else
+
+#ifdef ATTACKMAP
+
+    // attacks_sum() collects the attacks of all the pieces and the checkers,
+    // either recomputed from scratch or read from the incremental attack maps.
+    template<bool INCREMENTAL>
+    u64 attacks_sum (const Position &pos)
     {
-        ifstream ifs (fen_fn);
+        u64 sum = 0;
+        Bitboard occ = pos.pieces ();
+        Bitboard b   = occ;
+        while (b != U64 (0))
+        {
+            Square s = pop_lsq (b);
+            sum += INCREMENTAL ? pos.attacks_from (s) : attacks_bb (pos[s], s, occ);
+        }
+        Square k_sq = pos.king_sq (pos.active ());
+        sum ^= INCREMENTAL
+            ?  pos.attackers_at (k_sq)    & pos.pieces (~pos.active ())
+            :  pos.attackers_to (k_sq, occ) & pos.pieces (~pos.active ());
+        return sum;
+    }
+
+    // attacks_walk() visits all the nodes of the tree up to the depth (in plies)
+    // summing their attacks, the attack maps are updated by do_move()/undo_move() anyway.
+    template<bool INCREMENTAL>
+    u64 attacks_walk (Position &pos, u08 depth, u64 &nodes)
+    {
+        ++nodes;
+        u64 sum = attacks_sum<INCREMENTAL> (pos);
+        if (depth == 0) return sum;
+
+        StateInfo si;
+        for (MoveList<LEGAL> itr (pos); *itr != MOVE_NONE; ++itr)
+        {
+            pos.do_move (*itr, si);
+            sum += attacks_walk<INCREMENTAL> (pos, depth - 1, nodes);
+            pos.undo_move ();
+        }
+        return sum;
+    }
+
+#endif
+
+
+    // read_count() reads an optional count (passes, iterations, depth) of a suite,
+    // the default if it is missing, at least the given least
+    u32 read_count (istream &is, u32 count, u32 least = 1)
+    {
+        string token;
+        if (is >> token) count = abs (atoi (token.c_str ()));
+        return max (count, least);
+    }
+
+    // elapsed_since() returns the time (in ms) since the start,
+    // ensure non-zero to avoid a 'divide by zero'
+    point elapsed_since (point start)
+    {
+        point elapsed = now () - start;
+        return elapsed != 0 ? elapsed : 1;
+    }
+
+    // results() starts the results of a benchmark
+    void results ()
+    {
+        cerr << "\n===========================\n";
+    }
+
+    // field() starts a result line with its label, aligned with the others
+    ostream& field (const char *label)
+    {
+        return cerr << setw (16) << left << label << right << ": ";
+    }
+
+    // rate() prints a result line with the time (in ms) and the throughput of the work done
+    void rate (const char *label, point elapsed, u64 count, const char *unit)
+    {
+        field (label) << elapsed << " ms (" << count * 1000 / elapsed << " " << unit << "/second)\n";
+    }
+
+    // per_item() prints a result line with the time (in ns) per item of the work done
+    void per_item (const char *label, point elapsed, double items, const char *unit)
+    {
+        field (label) << setprecision (2) << fixed << double (elapsed) * 1e6 / items << " " << unit;
+    }
+
+    // setup_positions() sets up the positions of the fens, the fixture of most suites
+    void setup_positions (vector<Position> &positions, const char *const *fens, u16 total, Thread *thread, bool c960)
+    {
+        positions.resize (total);
+        for (u16 i = 0; i < total; ++i)
+        {
+            positions[i].setup (fens[i], thread, c960);
+        }
+    }
+
+    // clear_tables() clears the transposition table and the per-thread tables and statistics
+    void clear_tables ()
+    {
+        TT.master_clear ();
+        for (u08 t = 0; t < Threadpool.size (); ++t)
+        {
+            Threadpool[t]->eval_cache.clear ();
+            Threadpool[t]->lazy_stats.clear ();
+            Threadpool[t]->pawns_table.safety_probes = 0;
+            Threadpool[t]->pawns_table.safety_hits   = 0;
+        }
+    }
+
+    // search_fens() searches (or perfts) the positions one after another
+    // for the limits, returns the total of the nodes searched (or leaf nodes).
+    u64 search_fens (const vector<string> &fens, const LimitsT &limits, bool perft_only, StateInfoStackPtr &states, bool chess960)
+    {
+        u64 nodes = 0;
+        u16 total = fens.size ();
+        for (u16 i = 0; i < total; ++i)
+        {
+            Position root_pos (fens[i], Threadpool.main (), chess960);
+
+            cerr
+                << "\n--------------\n"
+                << "Position: " << (i + 1) << "/" << total << "\n";
+
+            if (perft_only)
+            {
+                u64 leaf_count = perft (root_pos, i32 (limits.depth) * ONE_MOVE);
+                cerr << "\nPerft " << u16 (limits.depth)  << " leaf nodes: " << leaf_count << "\n";
+                nodes += leaf_count;
+            }
+            else
+            {
+                Threadpool.start_thinking (root_pos, limits, states);
+                Threadpool.wait_for_think_finished ();
+                nodes += RootPos.game_nodes ();
+            }
+        }
+        return nodes;
+    }
+
+    // bench_search() runs a simple benchmark by letting engine analyze a set of positions for a given limit each.
+    // There are five optional parameters:
+    //  - transposition table size (default is 32 MB).
+    //  - number of search threads that should be used (default is 1 thread).
+    //  - limit value spent for each position (default is 13 depth),
+    //  - type of the limit value:
+    //     * 'depth' (default).
+    //     * 'time' in secs
+    //     * 'nodes' to search.
+    //     * 'mate' in moves
+    //  - filename where to look for positions in fen format (defaults are the positions defined above)
+    //     * 'default' for builtin position
+    //     * 'current' for current position
+    //     * '<filename>' containing fens position
+    // example: bench 32 1 10 depth default
+    void bench_search (istream &is, const Position &pos)
+    {
+        string token;
+        vector<string> fens;
+
+        // Assign default values to missing arguments
+        string hash       = (is >> token) ? token : "32";
+        string threads    = (is >> token) ? token : "1";
+        string limit_val  = (is >> token) ? token : "13";
+        string limit_type = (is >> token) ? token : "depth";
+        string fen_fn     = (is >> token) ? token : "default";
+
+        *Options["Hash"]    = hash;
+        *Options["Threads"] = threads;
+
+        clear_tables ();
+
+        i32     value = abs (atoi (limit_val.c_str ()));
+        //value = value >= 0 ? value : -value;
+
+        LimitsT limits;
+        if      (limit_type == "time")  limits.movetime = value * M_SEC; // movetime is in ms
+        else if (limit_type == "nodes") limits.nodes    = value;
+        else if (limit_type == "mate")  limits.mate     = value;
+        //else if (limit_type == "depth")
+        else                            limits.depth    = value;
+
+        StateInfoStackPtr states;
+
+        if      (fen_fn == "default")
+        {
+            fens.assign (DefaultFens, DefaultFens + FEN_TOTAL);
+            states = StateInfoStackPtr (new StateInfoStack ());
+        }
+        else if (fen_fn == "current")
+        {
+            fens.push_back (pos.fen ());
+        }
+        else
+        {
+            ifstream ifs (fen_fn);
+
+            if (!ifs.is_open ())
+            {
+                cerr << "ERROR: Unable to open file ... \'" << fen_fn << "\'" << endl;
+                return;
+            }
+
+            string fen;
+            while (getline (ifs, fen))
+            {
+                if (!fen.empty ())
+                {
+                    fens.push_back (fen);
+                }
+            }
+
+            ifs.close ();
+            states = StateInfoStackPtr (new StateInfoStack ());
+        }
+
+        bool chess960 = bool (*(Options["UCI_Chess960"]));
+        point start   = now ();
+        u64   nodes   = search_fens (fens, limits, limit_type == "perft", states, chess960);
+
+        cerr << "\n---------------------------\n";
+
+        Debugger::dbg_print (); // Just before to exit
+
+        point elapsed = elapsed_since (start);
+
+        results ();
+        field ("Total time (ms)") << elapsed << "\n";
+        field ("Nodes searched")  << nodes   << "\n";
+        field ("Nodes/second")    << nodes * 1000 / elapsed << endl;
+
+        u64 probes = 0
+          , hits   = 0;
+        for (u08 t = 0; t < Threadpool.size (); ++t)
+        {
+            probes += Threadpool[t]->eval_cache.probes;
+            hits   += Threadpool[t]->eval_cache.hits;
+        }
+        if (probes != 0)
+        {
+            field ("Eval cache hits") << hits << " of " << probes << " (" << hits * 100 / probes << "%)" << endl;
+        }
+
+        probes = 0;
+        hits   = 0;
+        for (u08 t = 0; t < Threadpool.size (); ++t)
+        {
+            probes += Threadpool[t]->pawns_table.safety_probes;
+            hits   += Threadpool[t]->pawns_table.safety_hits;
+        }
+        if (probes != 0)
+        {
+            field ("King safety hits") << hits << " of " << probes << " (" << hits * 100 / probes << "%)" << endl;
+        }
+
+        field ("Attack tables") << attack_table_size () / 1024 << " KB" << endl;
+
+        u64 evals  = 0
+          , exits  = 0
+          , checks = 0
+          , wrongs = 0;
+        for (u08 t = 0; t < Threadpool.size (); ++t)
+        {
+            evals  += Threadpool[t]->lazy_stats.evals;
+            exits  += Threadpool[t]->lazy_stats.exits;
+            checks += Threadpool[t]->lazy_stats.checks;
+            wrongs += Threadpool[t]->lazy_stats.wrongs;
+        }
+        if (exits != 0)
+        {
+            field ("Lazy eval exits") << exits << " of " << evals << " (" << exits * 100 / evals << "%)";
+            if (checks != 0)
+            {
+                cerr << ", wrong " << wrongs << " of " << checks << " verified (" << wrongs * 100 / checks << "%)";
+            }
+            cerr << endl;
+        }
+
+        if (bool (*(Options["Deterministic Search"])) && limit_type != "perft")
+        {
+            // The cost of determinism: the same searches again with the threads running free
+            string check = "false";
+            *Options["Deterministic Search"] = check;
+
+            clear_tables ();
+
+            point free_start = now ();
+            u64   free_nodes = search_fens (fens, limits, false, states, chess960);
+            point free_elapsed = elapsed_since (free_start);
+
+            check = "true";
+            *Options["Deterministic Search"] = check;
+
+            u64 nps      = nodes * 1000 / elapsed
+              , free_nps = free_nodes * 1000 / free_elapsed;
+            results ();
+            field ("Deterministic")    << u16 (Threadpool.size ()) << " thread(s) in turns, " << nps << " nodes/second\n";
+            field ("Free running")     << free_nodes << " nodes, " << free_nps << " nodes/second\n";
+            field ("Determinism cost") << (free_nps > nps ? (free_nps - nps) * 100 / free_nps : 0) << "% of the nps" << endl;
+        }
+    }
+
+    // bench_attacks() compares the attacks of all the pieces (and the checkers)
+    // recomputed from scratch with the ones read from the incremental attack maps,
+    // walking the tree of the builtin positions up to the given depth (default is 3 plies).
+    // Both walks pay the incremental update in do_move()/undo_move(), so the difference
+    // is the work the attack maps save to their consumers at each node.
+    // example: bench attacks 4
+    void bench_attacks (istream &is, const Position &pos)
+    {
+#ifdef ATTACKMAP
+
+        u08 depth = u08 (read_count (is, 3, 0));
+
+        vector<Position> positions;
+        setup_positions (positions, DefaultFens, FEN_TOTAL, pos.thread (), bool (*(Options["UCI_Chess960"])));
+
+        u64   sum[2]   = { 0, 0 }
+            , nodes[2] = { 0, 0 };
+        point elapsed[2];
+        for (u08 incremental = 0; incremental < 2; ++incremental)
+        {
+            point start = now ();
+            for (u16 i = 0; i < FEN_TOTAL; ++i)
+            {
+                sum[incremental] += incremental
+                    ? attacks_walk<true > (positions[i], depth, nodes[incremental])
+                    : attacks_walk<false> (positions[i], depth, nodes[incremental]);
+            }
+            elapsed[incremental] = elapsed_since (start);
+        }
+
+        results ();
+        field ("Nodes visited") << nodes[0] << "\n";
+        rate ("Full recompute", elapsed[0], nodes[0], "nodes");
+        rate ("Attack maps"   , elapsed[1], nodes[1], "nodes");
+        field ("Attacks match") << (sum[0] == sum[1] && nodes[0] == nodes[1] ? "yes" : "no") << endl;
+
+#else
+
+        (void) is;
+        (void) pos;
+        cerr << "Attack maps are not compiled in, build with attacks=yes" << endl;
+
+#endif
+    }
+
+    // bench_fills() compares the slider attacks computed by the magic lookups,
+    // one square at a time, with the ones computed by the SIMD occluded fills,
+    // a whole set of sliders at a time, over the slider sets of the tree of the
+    // builtin positions. There are two optional parameters:
+    //  - depth of the tree in plies (default is 2)
+    //  - number of passes over the slider sets (default is 20)
+    // example: bench fills 2 50
+    void bench_fills (istream &is, const Position &pos)
+    {
+        u08 depth  = u08 (read_count (is, 2, 0));
+        u32 passes = read_count (is, 20);
+
+        vector<Position> positions;
+        setup_positions (positions, DefaultFens, FEN_TOTAL, pos.thread (), bool (*(Options["UCI_Chess960"])));
+
+        vector<SliderSet> sets;
+        for (u16 i = 0; i < FEN_TOTAL; ++i)
+        {
+            sliders_walk (positions[i], depth, sets);
+        }
 
-        if (!ifs.is_open ())
+        u64 sliders = 0;
+        for (vector<SliderSet>::const_iterator itr = sets.begin (); itr != sets.end (); ++itr)
         {
-            cerr << "ERROR: Unable to open file ... \'" << fen_fn << "\'" << endl;
-            return;
+            for (const Square *pl = itr->sqs; *pl != SQ_NO; ++pl) ++sliders;
         }
+        sliders *= passes;
 
-        string fen;
-        while (getline (ifs, fen))
+        u64   sum[2] = { 0, 0 };
+        point elapsed[2];
+        for (u08 fill = 0; fill < 2; ++fill)
         {
-            if (!fen.empty ())
+            point start = now ();
+            for (u32 n = 0; n < passes; ++n)
             {
-                fens.push_back (fen);
+                sum[fill] += fill ? sliders_sum<true > (sets) : sliders_sum<false> (sets);
             }
+            elapsed[fill] = elapsed_since (start);
         }
 
-        ifs.close ();
-        states = StateInfoStackPtr (new StateInfoStack ());
+        results ();
+        field ("Slider sets") << sets.size () << " x " << passes << "\n";
+        field ("Sliders")     << sliders << "\n";
+        field ("Magic lookups") << elapsed[0] << " ms (" << sliders / elapsed[0] << " sliders/ms)\n";
+        field ("SIMD fills")    << elapsed[1] << " ms (" << sliders / elapsed[1] << " sliders/ms)\n";
+        field ("Attacks match") << (sum[0] == sum[1] ? "yes" : "no") << endl;
     }
-    
-    bool chess960  = bool (*(Options["UCI_Chess960"]));
-    u64 nodes      = 0;
-    point elapsed  = now ();
 
-    u16 total = fens.size ();
-    for (u16 i = 0; i < total; ++i)
+    // bench_sliders() compares the slider attack engines head to head: the table
+    // footprint and the time per lookup on realistic occupancies (the slider sets of
+    // the tree of the builtin positions, 2 plies), on random occupancies (random square
+    // and about a quarter of the squares occupied), and on the realistic ones while
+    // streaming a buffer much larger than the L2 which evicts the tables (the time of
+    // the stream alone is printed last). The last column is where the engines with big
+    // tables pay their L1/L2 misses, for the exact counts run it under 'perf stat'.
+    // There is one optional parameter:
+    //  - number of passes over the samples (default is 50)
+    // example: bench sliders 100
+    void bench_sliders (istream &is, const Position &pos)
     {
-        Position root_pos (fens[i], Threadpool.main (), chess960);
+        u32 passes = read_count (is, 50);
+
+        // The engines not selected at build time are not initialized at startup
+        Kindergarten::initialize ();
+        Sherwin::initialize ();
+
+        vector<Position> positions;
+        setup_positions (positions, DefaultFens, FEN_TOTAL, pos.thread (), bool (*(Options["UCI_Chess960"])));
+
+        vector<SliderSet> sets;
+        for (u16 i = 0; i < FEN_TOTAL; ++i)
+        {
+            sliders_walk (positions[i], 2, sets);
+        }
+
+        vector<SliderSample> realistic, random;
+        for (vector<SliderSet>::const_iterator itr = sets.begin (); itr != sets.end (); ++itr)
+        {
+            for (const Square *pl = itr->sqs; *pl != SQ_NO; ++pl)
+            {
+                SliderSample sample = { itr->occ, *pl, itr->pt };
+                realistic.push_back (sample);
+            }
+        }
+        RKISS rkiss (0xA5A5);
+        for (u32 i = 0; i < realistic.size (); ++i)
+        {
+            SliderSample sample =
+            {
+                rkiss.rand<Bitboard> () & rkiss.rand<Bitboard> (),
+                Square (rkiss.rand<u32> () % SQ_NO),
+                realistic[i].pt // Same sequence of piece types, same dispatch
+            };
+            random.push_back (sample);
+        }
 
+        vector<u08> stream (STREAM_SIZE, 1);
+
+        u64 sum = 0;
+        const SliderEngine none = { "Stream only", { no_attacks, no_attacks, no_attacks }, no_table_size };
+
+        const double lookups = double (realistic.size ()) * passes;
+
+        results ();
+        field ("Lookups") << realistic.size () << " x " << passes << "\n";
         cerr
-            << "\n--------------\n" 
-            << "Position: " << (i + 1) << "/" << total << "\n";
+            << "Engine          Tables (KB)  Realistic   Random  Streaming (ns/lookup)\n"
+            << setprecision (2) << fixed;
+
+        bool match = true;
+        for (u08 e = 0; e < SLIDER_ENGINES; ++e)
+        {
+            const SliderEngine &engine = SliderEngines[e];
+
+            u64 engine_sum = 0;
+            point elapsed[3];
+            elapsed[0] = sliders_time (engine, realistic, passes, NULL, engine_sum);
+            elapsed[1] = sliders_time (engine, random   , passes, NULL, engine_sum);
+            elapsed[2] = sliders_time (engine, realistic, passes, &stream[0], engine_sum);
+
+            // All the engines see the same lookups and the same stream
+            if (e == 0) sum = engine_sum;
+            match &= (sum == engine_sum);
+
+            cerr << setw (16) << left << engine.name << right
+                 << setw (11) << double (engine.table_size ()) / 1024
+                 << setw (11) << double (elapsed[0]) * 1e6 / lookups
+                 << setw ( 9) << double (elapsed[1]) * 1e6 / lookups
+                 << setw (11) << double (elapsed[2]) * 1e6 / lookups << "\n";
+        }
+        cerr << setw (16) << left << none.name << right << setw (53)
+             << double (sliders_time (none, realistic, passes, &stream[0], sum)) * 1e6 / lookups << "\n";
+        field ("Attacks match") << (match ? "yes" : "no") << endl;
+    }
+
+    // bench_movegen() runs the perft suite at depth 4 with the pseudo-legal generator
+    // filtered by Position::legal() and with the legal generator, checks the leaf nodes
+    // of both against the known counts and reports the generation throughput.
+    // There is one optional parameter:
+    //  - number of passes over the suite (default is 3)
+    // example: bench movegen 5
+    void bench_movegen (istream &is, const Position &pos)
+    {
+        u32 passes = read_count (is, 3);
+
+        vector<Position> positions;
+        setup_positions (positions, PerftFens, PERFT_TOTAL, pos.thread (), false);
+
+        u64   leafs[2] = { 0, 0 };
+        point elapsed[2];
+        bool  match = true;
+        for (u08 filtered = 0; filtered < 2; ++filtered)
+        {
+            point start = now ();
+            for (u32 n = 0; n < passes; ++n)
+            {
+                for (u08 i = 0; i < PERFT_TOTAL; ++i)
+                {
+                    u64 count = filtered
+                        ? perft_walk<true > (positions[i], 4)
+                        : perft_walk<false> (positions[i], 4);
+                    match &= (count == PerftLeafs[i]);
+                    leafs[filtered] += count;
+                }
+            }
+            elapsed[filtered] = elapsed_since (start);
+        }
+
+        results ();
+        field ("Leaf nodes") << leafs[0] << "\n";
+        rate ("Legal generator", elapsed[0], leafs[0], "moves");
+        rate ("Filtered pseudo", elapsed[1], leafs[1], "moves");
+        field ("Perft match") << (match && leafs[0] == leafs[1] ? "yes" : "no") << endl;
+    }
+
+    // bench_makes() makes all the moves of the perft suite at depth 4 with do-undo on
+    // the position and with copy-make on the positions of the plies, as done by the search
+    // when built with copy-make (COPYMAKE), checks the leaf nodes of both against the known
+    // counts and reports the make throughput.
+    // There is one optional parameter:
+    //  - number of passes over the suite (default is 3)
+    // example: bench makes 5
+    void bench_makes (istream &is, const Position &pos)
+    {
+        u32 passes = read_count (is, 3);
+
+        vector<Position> plies (4 + 1);
+
+        u64   leafs[2] = { 0, 0 };
+        point elapsed[2];
+        bool  match = true;
+        for (u08 copy = 0; copy < 2; ++copy)
+        {
+            point start = now ();
+            for (u32 n = 0; n < passes; ++n)
+            {
+                for (u08 i = 0; i < PERFT_TOTAL; ++i)
+                {
+                    plies[0].setup (PerftFens[i], pos.thread (), false);
+                    u64 count = copy
+                        ? make_walk<true > (plies[0], &plies[0], 4)
+                        : make_walk<false> (plies[0], &plies[0], 4);
+                    match &= (count == PerftLeafs[i]);
+                    leafs[copy] += count;
+                }
+            }
+            elapsed[copy] = elapsed_since (start);
+        }
+
+        results ();
+        field ("Leaf nodes")    << leafs[0] << "\n";
+        field ("Position copy") << Position::copy_size () << " bytes\n";
+        rate ("Do-undo"  , elapsed[0], leafs[0], "leafs");
+        rate ("Copy-make", elapsed[1], leafs[1], "leafs");
+        field ("Perft match") << (match && leafs[0] == leafs[1] ? "yes" : "no") << endl;
+    }
+
+    // bench_captures() generates the captures of the nodes of the perft suite up to
+    // depth 3 with the general generator and with the one which gives them already in
+    // MVV/LVA order (used by the quiescence search when built with MVVLVA),
+    // checks both give the same moves and reports the generation throughput.
+    // There is one optional parameter:
+    //  - number of passes over the suite (default is 3)
+    // example: bench captures 5
+    void bench_captures (istream &is, const Position &pos)
+    {
+        u32 passes = read_count (is, 3);
+
+        vector<Position> positions;
+        setup_positions (positions, PerftFens, PERFT_TOTAL, pos.thread (), false);
+
+        u64   count[2] = { 0, 0 }
+            , sum  [2] = { 0, 0 };
+        point elapsed[2];
+        for (u08 ordered = 0; ordered < 2; ++ordered)
+        {
+            point start = now ();
+            for (u32 n = 0; n < passes; ++n)
+            {
+                for (u08 i = 0; i < PERFT_TOTAL; ++i)
+                {
+                    ordered
+                        ? captures_walk<QS_CAPTURE> (positions[i], 3, count[ordered], sum[ordered])
+                        : captures_walk<CAPTURE   > (positions[i], 3, count[ordered], sum[ordered]);
+                }
+            }
+            elapsed[ordered] = elapsed_since (start);
+        }
+
+        results ();
+        field ("Captures") << count[0] << "\n";
+        rate ("General"        , elapsed[0], count[0], "moves");
+        rate ("MVV/LVA ordered", elapsed[1], count[1], "moves");
+        field ("Moves match") << (count[0] == count[1] && sum[0] == sum[1] ? "yes" : "no") << endl;
+    }
+
+    // bench_picker() times the move picker of the main search on the builtin positions,
+    // with a random history, taking only the first moves as at the cut nodes where one
+    // or two moves are tried, and taking all the moves as at the all nodes,
+    // then the move picker of the quiescence search taking all the captures.
+    // There is one optional parameter:
+    //  - number of iterations (default is 20000)
+    // example: bench picker 20000
+    void bench_picker (istream &is, const Position &pos)
+    {
+        u32 iterations = read_count (is, 20000);
+
+        vector<Position> positions;
+        setup_positions (positions, DefaultFens, FEN_TOTAL, pos.thread (), bool (*(Options["UCI_Chess960"])));
+
+        HistoryStats history;
+        history.clear ();
+        RKISS rkiss (0xA5A5);
+        for (u16 i = 0; i < FEN_TOTAL; ++i)
+        {
+            const Position &p = positions[i];
+            for (MoveList<QUIET> itr (p); *itr != MOVE_NONE; ++itr)
+            {
+                history.update (p[org_sq (*itr)], dst_sq (*itr), Value (i32 (rkiss.rand<u32> () % 4001) - 2000));
+            }
+        }
+
+        Stack stack[4];
+        memset (stack, 0, sizeof (stack));
+        Move cm[CLR_NO] = { MOVE_NONE, MOVE_NONE }
+           , fm[CLR_NO] = { MOVE_NONE, MOVE_NONE };
+
+        const u08 CutPicks = 2;
+        u64   sum     = 0
+            , picks[3] = { 0, 0, 0 };
+        point elapsed[3];
+        for (u08 all = 0; all < 2; ++all)
+        {
+            point start = now ();
+            for (u32 n = 0; n < iterations; ++n)
+            {
+                for (u16 i = 0; i < FEN_TOTAL; ++i)
+                {
+                    MovePicker mp (positions[i], history, MOVE_NONE, 6 * ONE_MOVE, cm, fm, stack+2);
+                    Move m;
+                    u08 count = 0;
+                    while ((all || count < CutPicks) && (m = mp.next_move<false> ()) != MOVE_NONE)
+                    {
+                        sum += m;
+                        ++count;
+                    }
+                    picks[all] += count;
+                }
+            }
+            elapsed[all] = now () - start;
+        }
+        point start = now ();
+        for (u32 n = 0; n < iterations; ++n)
+        {
+            for (u16 i = 0; i < FEN_TOTAL; ++i)
+            {
+                MovePicker mp (positions[i], history, MOVE_NONE, DEPTH_QS_NO_CHECKS, SQ_NO);
+                Move m;
+                while ((m = mp.next_move<false> ()) != MOVE_NONE)
+                {
+                    sum += m;
+                    ++picks[2];
+                }
+            }
+        }
+        elapsed[2] = now () - start;
+
+        const double pickers = double (iterations) * FEN_TOTAL;
+        results ();
+        field ("Pickers") << u16 (FEN_TOTAL) << " x " << iterations << "\n";
+        per_item ("Cut node"  , elapsed[0], pickers, "ns/node"); cerr << " (" << double (picks[0]) / pickers << " moves)\n";
+        per_item ("All node"  , elapsed[1], pickers, "ns/node"); cerr << " (" << double (picks[1]) / pickers << " moves)\n";
+        per_item ("Quiescence", elapsed[2], pickers, "ns/node"); cerr << " (" << double (picks[2]) / pickers << " moves)\n";
+        field ("Checksum") << sum << endl;
+    }
+
+    // bench_copies() times the copy of the builtin positions, as done by the threads
+    // joining a splitpoint, against the copy of the whole object with the castling data,
+    // as it was done before the castling data was shared and the network layer was
+    // left out of the copies (when the network is not active).
+    // There is one optional parameter:
+    //  - number of iterations (default is 1000000)
+    // example: bench copies 1000000
+    void bench_copies (istream &is, const Position &pos)
+    {
+        u32 iterations = read_count (is, 1000000);
 
-        if (limit_type == "perft")
+        vector<Position> positions;
+        setup_positions (positions, DefaultFens, FEN_TOTAL, pos.thread (), bool (*(Options["UCI_Chess960"])));
+        vector<Position> copies (FEN_TOTAL);
+
+        // The whole object with the castling data, the size of a position before
+        struct FullCopy { Position pos; CastleInfo castle; };
+        vector<FullCopy> full_positions (FEN_TOTAL), full_copies (FEN_TOTAL);
+        for (u16 i = 0; i < FEN_TOTAL; ++i)
         {
-            u64 leaf_count = perft (root_pos, i32 (limits.depth) * ONE_MOVE);
-            cerr << "\nPerft " << u16 (limits.depth)  << " leaf nodes: " << leaf_count << "\n";
-            nodes += leaf_count;
+            memcpy (static_cast<void*> (&full_positions[i].pos), &positions[i], sizeof (Position));
+        }
+
+        u64   sum[2] = { 0, 0 };
+        point elapsed[2];
+        for (u08 full = 0; full < 2; ++full)
+        {
+            point start = now ();
+            for (u32 n = 0; n < iterations; ++n)
+            {
+                for (u16 i = 0; i < FEN_TOTAL; ++i)
+                {
+                    if (full)
+                    {
+                        memcpy (static_cast<void*> (&full_copies[i]), &full_positions[i], sizeof (FullCopy));
+                        sum[full] += full_copies[i].pos.posi_key ();
+                    }
+                    else
+                    {
+                        copies[i] = positions[i];
+                        sum[full] += copies[i].posi_key ();
+                    }
+                }
+            }
+            elapsed[full] = now () - start;
+        }
+
+        const double copied = double (iterations) * FEN_TOTAL;
+        results ();
+        field ("Copies") << u16 (FEN_TOTAL) << " x " << iterations << "\n";
+        field ("Position copy") << setw (5) << Position::copy_size () << " bytes ";
+        cerr << setprecision (2) << fixed << double (elapsed[0]) * 1e6 / copied << " ns/copy\n";
+        field ("Full copy") << setw (5) << sizeof (FullCopy) << " bytes ";
+        cerr << double (elapsed[1]) * 1e6 / copied << " ns/copy\n";
+        field ("Keys match") << (sum[0] == sum[1] ? "yes" : "no") << endl;
+    }
+
+    // bench_endgames() times the endgame functions of the builtin endgame positions:
+    // the dispatch (the probes of the endgame table for an evaluation and a scaling
+    // function, as the material table does) and the call of the function itself.
+    // There is one optional parameter:
+    //  - number of iterations (default is 1000000)
+    // example: bench endgames 1000000
+    void bench_endgames (istream &is, const Position &pos)
+    {
+        u32 iterations = read_count (is, 1000000);
+
+        Position positions[ENDGAME_TOTAL];
+        Key keys[ENDGAME_TOTAL];
+        for (u08 i = 0; i < ENDGAME_TOTAL; ++i)
+        {
+            positions[i].setup (EndgameFens[i][1], pos.thread ());
+            keys[i] = positions[i].matl_key ();
+        }
+
+        // The sum of the results keeps the calls from being optimized away
+        u64 sum = 0;
+
+        EndGame::EndgameBase<Value>       *eval_func;
+        EndGame::EndgameBase<ScaleFactor> *scale_func;
+        point start = now ();
+        for (u32 n = 0; n < iterations; ++n)
+        {
+            for (u08 i = 0; i < ENDGAME_TOTAL; ++i)
+            {
+                sum += (EndGame::EndgameTable->probe (keys[i], eval_func ) != NULL)
+                    +  (EndGame::EndgameTable->probe (keys[i], scale_func) != NULL);
+            }
+        }
+        point elapsed = now () - start;
+
+        results ();
+        field ("Iterations") << iterations << "\n";
+        per_item ("Dispatch", elapsed, double (iterations) * ENDGAME_TOTAL, "ns/position\n");
+        field ("Endgame") << "  ns/call\n";
+
+        for (u08 i = 0; i < ENDGAME_TOTAL; ++i)
+        {
+            const Position &p  = positions[i];
+            Material::Entry *e = Material::probe (p, p.thread ()->material_table);
+
+            start = now ();
+            for (u32 n = 0; n < iterations; ++n)
+            {
+                sum += e->specialized_eval_exists ()
+                    ?  e->evaluate (p)
+                    :  e->scale_factor (p, WHITE) + e->scale_factor (p, BLACK);
+            }
+            elapsed = now () - start;
+
+            cerr << "  " << setw (14) << left << EndgameFens[i][0] << right
+                 << setw (8) << double (elapsed) * 1e6 / iterations << "\n";
+        }
+        field ("Checksum") << sum << endl;
+    }
+
+    // bench_batch() packs a set of positions and evaluates them with the batch API
+    // on all the threads, first the values alone then with the breakdown of the terms.
+    // The values are checked against the evaluation of each position one at a time.
+    // There is one optional parameter:
+    //  - filename where to look for positions in fen format (default are all the
+    //    positions up to 2 plies from the builtin positions)
+    // example: bench evalbatch positions.fen
+    void bench_batch (istream &is, const Position &pos)
+    {
+        string fen_fn;
+        if (!(is >> fen_fn)) fen_fn = "default";
+
+        bool chess960 = bool (*(Options["UCI_Chess960"]));
+
+        vector<PackedPosition> packeds;
+        PackedPosition pp;
+        if (fen_fn == "default")
+        {
+            vector<Position> positions;
+            setup_positions (positions, DefaultFens, FEN_TOTAL, pos.thread (), chess960);
+
+            StateInfo si[2];
+            for (u16 i = 0; i < FEN_TOTAL; ++i)
+            {
+                Position &root_pos = positions[i];
+                root_pos.pack (pp);
+                packeds.push_back (pp);
+                for (MoveList<LEGAL> itr1 (root_pos); *itr1 != MOVE_NONE; ++itr1)
+                {
+                    root_pos.do_move (*itr1, si[0]);
+                    root_pos.pack (pp);
+                    packeds.push_back (pp);
+                    for (MoveList<LEGAL> itr2 (root_pos); *itr2 != MOVE_NONE; ++itr2)
+                    {
+                        root_pos.do_move (*itr2, si[1]);
+                        root_pos.pack (pp);
+                        packeds.push_back (pp);
+                        root_pos.undo_move ();
+                    }
+                    root_pos.undo_move ();
+                }
+            }
         }
         else
         {
+            ifstream ifs (fen_fn);
+
+            if (!ifs.is_open ())
+            {
+                cerr << "ERROR: Unable to open file ... \'" << fen_fn << "\'" << endl;
+                return;
+            }
+
+            string fen;
+            while (getline (ifs, fen))
+            {
+                if (!fen.empty ())
+                {
+                    Position p (fen, pos.thread (), chess960);
+                    p.pack (pp);
+                    packeds.push_back (pp);
+                }
+            }
+
+            ifs.close ();
+        }
+
+        if (packeds.empty ()) return;
+
+        for (u08 t = 0; t < Threadpool.size (); ++t)
+        {
+            Threadpool[t]->eval_cache.clear ();
+        }
+
+        u64 count = packeds.size ();
+        vector<Value> values (count)
+                    , values_terms (count);
+        vector<Evaluator::EvalTerms> terms (count);
+
+        point start = now ();
+        u64 evaluated = Evaluator::evaluate_batch (&packeds[0], count, &values[0], NULL, chess960);
+        point elapsed = elapsed_since (start);
+
+        start = now ();
+        Evaluator::evaluate_batch (&packeds[0], count, &values_terms[0], &terms[0], chess960);
+        point elapsed_terms = elapsed_since (start);
+
+        u64 mismatches = 0;
+        for (u64 i = 0; i < count; ++i)
+        {
+            Position p (0);
+            Value value = (p.setup (packeds[i], Threadpool.main (), chess960) && p.checkers () == U64 (0))
+                ? Evaluator::evaluate (p) : VALUE_NONE;
+            if (value != values[i] || value != values_terms[i]) ++mismatches;
+        }
+
+        results ();
+        field ("Positions") << count << " (" << evaluated << " evaluated, not in check)\n";
+        field ("Threads")   << u16 (Threadpool.size ()) << "\n";
+        rate ("Values"        , elapsed      , count, "positions");
+        rate ("Values + terms", elapsed_terms, count, "positions");
+        field ("Mismatches") << mismatches << endl;
+    }
+
+    // bench_fens() times the conversions of the positions up to 1 ply from the builtin
+    // positions: fen parsing, fen writing, packing and unpacking, then the streaming of
+    // the positions written to a fen file and to a packed file and read back.
+    // The positions read back are checked against the packed original ones.
+    // There are two optional parameters:
+    //  - number of passes over the positions (default is 100)
+    //  - filename of the files written, with the extensions .fen and .bin (default is "positions")
+    // example: bench fens 100 positions
+    void bench_fens (istream &is, const Position &pos)
+    {
+        u32 passes = read_count (is, 100);
+        string fn;
+        if (!(is >> fn)) fn = "positions";
+
+        bool chess960 = bool (*(Options["UCI_Chess960"]));
+
+        vector<Position> roots;
+        setup_positions (roots, DefaultFens, FEN_TOTAL, pos.thread (), chess960);
+
+        vector<string> fens;
+        StateInfo si;
+        for (u16 i = 0; i < FEN_TOTAL; ++i)
+        {
+            Position &root_pos = roots[i];
+            fens.push_back (root_pos.fen (chess960));
+            for (MoveList<LEGAL> itr (root_pos); *itr != MOVE_NONE; ++itr)
+            {
+                root_pos.do_move (*itr, si);
+                fens.push_back (root_pos.fen (chess960));
+                root_pos.undo_move ();
+            }
+        }
+
+        u32 count = u32 (fens.size ());
+        vector<Position>       positions (count);
+        vector<PackedPosition> packeds (count);
+        for (u32 i = 0; i < count; ++i)
+        {
+            positions[i].setup (fens[i], pos.thread (), chess960);
+            positions[i].pack (packeds[i]);
+        }
+
+        u64   sum = 0
+            , conversions = u64 (passes) * count;
+        point elapsed[6];
+        point start;
+        char  buf[FEN_LEN + 1];
+        Position p (0);
+
+        start = now ();
+        for (u32 n = 0; n < passes; ++n)
+        {
+            for (u32 i = 0; i < count; ++i)
+            {
+                p.setup (fens[i].c_str (), pos.thread (), chess960);
+                sum += p.posi_key ();
+            }
+        }
+        elapsed[0] = elapsed_since (start);
+
+        start = now ();
+        for (u32 n = 0; n < passes; ++n)
+        {
+            for (u32 i = 0; i < count; ++i)
+            {
+                positions[i].fen (buf, chess960);
+                sum += u08 (buf[0]);
+            }
+        }
+        elapsed[1] = elapsed_since (start);
+
+        PackedPosition pp;
+        start = now ();
+        for (u32 n = 0; n < passes; ++n)
+        {
+            for (u32 i = 0; i < count; ++i)
+            {
+                positions[i].pack (pp);
+                sum += pp.occupied;
+            }
+        }
+        elapsed[2] = elapsed_since (start);
+
+        start = now ();
+        for (u32 n = 0; n < passes; ++n)
+        {
+            for (u32 i = 0; i < count; ++i)
+            {
+                p.setup (packeds[i], pos.thread (), chess960);
+                sum += p.posi_key ();
+            }
+        }
+        elapsed[3] = elapsed_since (start);
+
+        // Streams, each position written and read back 'passes' times
+        string fen_fn = fn + ".fen"
+             , bin_fn = fn + ".bin";
+        u64 mismatches = 0
+          , dropped    = 0
+          , streamed[2] = { 0, 0 };
+
+        start = now ();
+        {
+            FenWriter fw (fen_fn);
+            for (u32 n = 0; n < passes; ++n)
+            {
+                for (u32 i = 0; i < count; ++i)
+                {
+                    fw.write (positions[i], chess960);
+                }
+            }
+            dropped = fw.dropped ();
+        }
+        {
+            FenReader fr (fen_fn);
+            while (fr.read (p, pos.thread (), chess960))
+            {
+                p.pack (pp);
+                mismatches += (memcmp (&pp, &packeds[streamed[0] % count], sizeof (pp)) != 0);
+                ++streamed[0];
+            }
+        }
+        elapsed[4] = elapsed_since (start);
+
+        start = now ();
+        {
+            PackedWriter pw (bin_fn);
+            for (u32 n = 0; n < passes; ++n)
+            {
+                for (u32 i = 0; i < count; ++i)
+                {
+                    pw.write (positions[i]);
+                }
+            }
+        }
+        {
+            PackedReader pr (bin_fn);
+            while (pr.read (p, pos.thread (), chess960))
+            {
+                p.pack (pp);
+                mismatches += (memcmp (&pp, &packeds[streamed[1] % count], sizeof (pp)) != 0);
+                ++streamed[1];
+            }
+        }
+        elapsed[5] = elapsed_since (start);
+
+        remove (fen_fn.c_str ());
+        remove (bin_fn.c_str ());
+
+        results ();
+        field ("Positions") << count << " x " << passes << "\n";
+        rate ("Fen parse"    , elapsed[0], conversions, "positions");
+        rate ("Fen write"    , elapsed[1], conversions, "positions");
+        rate ("Pack"         , elapsed[2], conversions, "positions");
+        rate ("Unpack"       , elapsed[3], conversions, "positions");
+        rate ("Fen stream"   , elapsed[4], conversions, "positions");
+        rate ("Packed stream", elapsed[5], conversions, "positions");
+        field ("Streamed") << streamed[0] << " fen, " << streamed[1] << " packed, " << mismatches << " mismatches\n";
+        field ("Dropped") << dropped << " fen\n";
+        field ("Checksum") << sum << endl;
+    }
+
+    // bench_repetitions() searches endgames where neither side can make progress,
+    // reached after a long shuffle of reversible moves, so the 50-move clock is high and
+    // the path since the last irreversible move is long, as in the analysis of a fortress
+    // where every node checks the repetitions. The shuffle (no capture, no pawn move,
+    // no castling) is random but the same on every run.
+    // The draw check of the roots is also timed alone, walking the whole path (as done
+    // by a position with no thread) and through the repetition table of the thread.
+    // There are two optional parameters:
+    //  - depth of the search (default is 28)
+    //  - number of plies of the shuffle (default is 80)
+    // example: bench repetitions 28 80
+    void bench_repetitions (istream &is, const Position &)
+    {
+        i32 depth   = read_count (is, 28);
+        i32 shuffle = read_count (is, 80, 0);
+
+        TT.master_clear ();
+
+        LimitsT limits;
+        limits.depth = depth;
+
+        const u32 DrawChecks = 1000000;
+
+        RKISS rkiss (0x5EED);
+        u64   nodes   = 0
+            , draws   = 0;
+        point elapsed = 0
+            , elapsed_draw[2] = { 0, 0 };
+        for (u08 i = 0; i < FORTRESS_TOTAL; ++i)
+        {
+            StateInfoStackPtr states (new StateInfoStack ());
+            Position root_pos (FortressFens[i], Threadpool.main (), false);
+
+            for (i32 ply = 0; ply < shuffle; ++ply)
+            {
+                vector<Move> reversibles;
+                for (MoveList<LEGAL> itr (root_pos); *itr != MOVE_NONE; ++itr)
+                {
+                    if (   !root_pos.capture_or_promotion (*itr)
+                        && PAWN != ptype (root_pos[org_sq (*itr)])
+                        && CASTLE != mtype (*itr))
+                    {
+                        reversibles.push_back (*itr);
+                    }
+                }
+                if (reversibles.empty ()) break;
+
+                states->push (StateInfo ());
+                root_pos.do_move (reversibles[rkiss.rand<u32> () % reversibles.size ()], states->top ());
+            }
+
+            Position walk_pos (root_pos, NULL);
+            Threadpool.main ()->repetitions.clear ();
+            root_pos.count_path (true);
+            for (u08 table = 0; table < 2; ++table)
+            {
+                const Position &p = table ? root_pos : walk_pos;
+                point start = now ();
+                for (u32 n = 0; n < DrawChecks; ++n)
+                {
+                    draws += p.draw ();
+                }
+                elapsed_draw[table] += now () - start;
+            }
+            root_pos.count_path (false);
+
+            cerr
+                << "\n--------------\n"
+                << "Position: " << u16 (i + 1) << "/" << u16 (FORTRESS_TOTAL)
+                << " (50-move clock " << u16 (root_pos.clock50 ()) << ")\n";
+
+            point start = now ();
             Threadpool.start_thinking (root_pos, limits, states);
             Threadpool.wait_for_think_finished ();
-            nodes += RootPos.game_nodes ();
+            elapsed += now () - start;
+            nodes   += RootPos.game_nodes ();
         }
+
+        // Ensure non-zero to avoid a 'divide by zero'
+        if (elapsed == 0) elapsed = 1;
+
+        results ();
+        field ("Total time (ms)") << elapsed << "\n";
+        field ("Nodes searched")  << nodes   << "\n";
+        field ("Nodes/second")    << nodes * 1000 / elapsed << "\n";
+        field ("Draw check") << setprecision (2) << fixed
+            << double (elapsed_draw[0]) * 1e6 / (DrawChecks * FORTRESS_TOTAL) << " ns walking, "
+            << double (elapsed_draw[1]) * 1e6 / (DrawChecks * FORTRESS_TOTAL) << " ns with the table ("
+            << draws << " draws)" << endl;
     }
 
-    cerr<< "\n---------------------------\n";
+    typedef void (*BenchSuite) (istream &is, const Position &pos);
 
-    Debugger::dbg_print (); // Just before to exit
+    // Benchmarks of the components, run by 'bench <suite> [parameters]'
+    const struct { const char *name; BenchSuite run; } Suites[] =
+    {
+        { "attacks"    , bench_attacks     },
+        { "fills"      , bench_fills       },
+        { "sliders"    , bench_sliders     },
+        { "movegen"    , bench_movegen     },
+        { "makes"      , bench_makes       },
+        { "captures"   , bench_captures    },
+        { "picker"     , bench_picker      },
+        { "copies"     , bench_copies      },
+        { "endgames"   , bench_endgames    },
+        { "evalbatch"  , bench_batch       },
+        { "fens"       , bench_fens        },
+        { "repetitions", bench_repetitions },
+    };
 
-    elapsed = now () - elapsed;
-    // Ensure non-zero to avoid a 'divide by zero'
-    if (elapsed == 0) elapsed = 1;
+    const u08 SUITES = sizeof (Suites) / sizeof (*Suites);
+
+}
 
-    cerr
-        << "\n===========================\n"
-        << "Total time (ms) : " << elapsed << "\n"
-        << "Nodes searched  : " << nodes   << "\n"
-        << "Nodes/second    : " << nodes * 1000 / elapsed
-        << endl;
+// benchmark() runs the benchmark named by the first parameter, with the parameters
+// which follow it, or the search benchmark (see bench_search()) if it is not a name:
+//  - 'bench [hash] [threads] [limit] [limit type] [fens]' searches the positions,
+//  - 'bench <suite> [parameters]' runs the benchmark of a component (see the suites above).
+// example: bench movegen 5
+void benchmark (istream &is, const Position &pos)
+{
+    string token;
+    if (is >> token)
+    {
+        for (u08 s = 0; s < SUITES; ++s)
+        {
+            if (token == Suites[s].name)
+            {
+                Suites[s].run (is, pos);
+                return;
+            }
+        }
+    }
 
+    // Not a suite, the parameters of the search benchmark start with the token
+    string args = token;
+    while (is >> token) args += " " + token;
+    istringstream iss (args);
+    bench_search (iss, pos);
 }
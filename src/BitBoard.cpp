@@ -6,6 +6,14 @@
 #include "BitScan.h"
 #include "RKISS.h"
 
+#if defined(__AVX2__)
+#   include <immintrin.h>
+#   define FILL_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   include <emmintrin.h>
+#   define FILL_SSE2
+#endif
+
 namespace BitBoard {
 
     using namespace std;
@@ -32,8 +40,13 @@ namespace BitBoard {
     // Attacks of the pieces
     CACHE_ALIGN(64) Bitboard PieceAttacks[NONE][SQ_NO];
 
-    CACHE_ALIGN(64) Bitboard*BAttack_bb[SQ_NO];
-    CACHE_ALIGN(64) Bitboard*RAttack_bb[SQ_NO];
+    CACHE_ALIGN(64) AttackEntry*BAttack_bb[SQ_NO];
+    CACHE_ALIGN(64) AttackEntry*RAttack_bb[SQ_NO];
+
+#ifdef COMPACT
+    CACHE_ALIGN(64) Bitboard DiagLine_bb[2][SQ_NO];
+    CACHE_ALIGN(64) Bitboard FileSpread_bb[256];
+#endif
 
     CACHE_ALIGN(64) Bitboard   BMask_bb[SQ_NO];
     CACHE_ALIGN(64) Bitboard   RMask_bb[SQ_NO];
@@ -86,12 +99,67 @@ namespace BitBoard {
         //                           102400 = 0x19000
         const u32 MAX_RMOVES = U32 (0x19000);
 
-        CACHE_ALIGN(64) Bitboard BTable_bb[MAX_BMOVES];
-        CACHE_ALIGN(64) Bitboard RTable_bb[MAX_RMOVES];
+        CACHE_ALIGN(64) AttackEntry BTable_bb[MAX_BMOVES];
+        CACHE_ALIGN(64) AttackEntry RTable_bb[MAX_RMOVES];
 
         typedef u16 (*Indexer) (Square s, Bitboard occ);
+        typedef AttackEntry (*Compressor) (Square s, Bitboard attacks);
+
+        template<PieceT PT>
+        // compress() returns the entry of the attacks in the table
+        AttackEntry compress (Square s, Bitboard attacks);
+
+#ifdef COMPACT
+
+        template<>
+        AttackEntry compress<BSHP> (Square s, Bitboard attacks)
+        {
+            // One square per file on a diagonal, the product gathers them in the top byte
+            return u16 (((attacks & DiagLine_bb[0][s]) * FA_bb) >> 0x38)
+                 | u16 (((attacks & DiagLine_bb[1][s]) * FA_bb) >> 0x38) << 8;
+        }
+        template<>
+        AttackEntry compress<ROOK> (Square s, Bitboard attacks)
+        {
+            u16 file8 = 0;
+            for (Rank r = R_1; r <= R_8; ++r)
+            {
+                if (attacks & (_file (s) | r)) file8 |= 1 << r;
+            }
+            return u16 ((attacks >> (s & 0x38)) & 0xFF) | file8 << 8;
+        }
+
+        void initialize_compact ()
+        {
+            const Delta Diag18Deltas[3] = { DEL_NE, DEL_SW, DEL_O };
+            const Delta Diag81Deltas[3] = { DEL_NW, DEL_SE, DEL_O };
+            for (Square s = SQ_A1; s <= SQ_H8; ++s)
+            {
+                DiagLine_bb[0][s] = sliding_attacks (Diag18Deltas, s);
+                DiagLine_bb[1][s] = sliding_attacks (Diag81Deltas, s);
+            }
+            for (u16 file8 = 0; file8 < 256; ++file8)
+            {
+                FileSpread_bb[file8] = U64 (0);
+                for (Rank r = R_1; r <= R_8; ++r)
+                {
+                    if (file8 & (1 << r)) FileSpread_bb[file8] |= (F_A | r);
+                }
+            }
+        }
 
-        void initialize_table (Bitboard table_bb[], Bitboard *attacks_bb[], Bitboard magics_bb[], Bitboard masks_bb[], u08 shift[], const Delta deltas[], const Indexer m_index)
+#else
+
+        template<>
+        AttackEntry compress<BSHP> (Square, Bitboard attacks) { return attacks; }
+        template<>
+        AttackEntry compress<ROOK> (Square, Bitboard attacks) { return attacks; }
+
+        void initialize_compact () {}
+
+#endif
+
+        void initialize_table (AttackEntry table_bb[], AttackEntry *attacks_bb[], Bitboard magics_bb[], Bitboard masks_bb[], u08 shift[], const Delta deltas[], const Indexer m_index, const Compressor m_compress)
         {
 
             const u16 MagicBoosters[R_NO] =
@@ -101,8 +169,8 @@ namespace BitBoard {
             { 0x3C9, 0x7B8, 0xB22, 0x21E, 0x815, 0xB24, 0x6AC, 0x0A4 }; // 32-bit
 #       endif
 
-            Bitboard occupancy[MAX_LMOVES];
-            Bitboard reference[MAX_LMOVES];
+            Bitboard    occupancy[MAX_LMOVES];
+            AttackEntry reference[MAX_LMOVES];
 
             RKISS rkiss;
 
@@ -136,7 +204,7 @@ namespace BitBoard {
                 do
                 {
                     occupancy[size] = occ;
-                    reference[size] = sliding_attacks (deltas, s, occ);
+                    reference[size] = m_compress (s, sliding_attacks (deltas, s, occ));
                     ++size;
                     occ = (occ - mask) & mask;
                 }
@@ -149,6 +217,16 @@ namespace BitBoard {
                     attacks_bb[s + 1] = attacks_bb[s] + size;
                 }
 
+#       ifdef BMI2
+                // PEXT of the occupancy by the mask is the index itself, no magic to find
+                magics_bb[s] = U64 (0);
+                for (u32 i = 0; i < size; ++i)
+                {
+                    attacks_bb[s][m_index (s, occupancy[i])] = reference[i];
+                }
+                continue;
+#       endif
+
                 u16 booster = MagicBoosters[_rank (s)];
 
                 // Find a magic for square 's' picking up an (almost) random number
@@ -165,7 +243,7 @@ namespace BitBoard {
                     }
                     while (pop_count<MAX15> (index) < 6);
 
-                    memset (attacks_bb[s], 0, size * sizeof (Bitboard));
+                    memset (attacks_bb[s], 0, size * sizeof (AttackEntry));
 
                     // A good magic must map every possible occupancy to an index that
                     // looks up the correct sliding attack in the attacks_bb[s] database.
@@ -173,7 +251,7 @@ namespace BitBoard {
                     // effect of verifying the magic.
                     for (i = 0; i < size; ++i)
                     {
-                        Bitboard &attacks = attacks_bb[s][m_index (s, occupancy[i])];
+                        AttackEntry &attacks = attacks_bb[s][m_index (s, occupancy[i])];
 
                         if (attacks && (attacks != reference[i]))
                         {
@@ -191,10 +269,237 @@ namespace BitBoard {
 
         void initialize_sliding ()
         {
-            initialize_table (BTable_bb, BAttack_bb, BMagic_bb, BMask_bb, BShift, PieceDeltas[BSHP], magic_index<BSHP>);
-            initialize_table (RTable_bb, RAttack_bb, RMagic_bb, RMask_bb, RShift, PieceDeltas[ROOK], magic_index<ROOK>);
+            initialize_compact ();
+            initialize_table (BTable_bb, BAttack_bb, BMagic_bb, BMask_bb, BShift, PieceDeltas[BSHP], magic_index<BSHP>, compress<BSHP>);
+            initialize_table (RTable_bb, RAttack_bb, RMagic_bb, RMask_bb, RShift, PieceDeltas[ROOK], magic_index<ROOK>, compress<ROOK>);
+        }
+
+    }
+
+    namespace {
+
+#if defined(FILL_AVX2)
+
+        // AVX2 lanes hold the four directions of one slider, each lane is shifted
+        // by its own count (left or right, the other count is 64 which gives zero).
+        // The directions are NE, NW, SE, SW for the bishop and N, S, E, W for the rook.
+        struct Directions
+        {
+            __m256i lshift[3]; // Shifts of the 1, 2, 4 steps of the fill
+            __m256i rshift[3];
+            __m256i wrap;      // Clears the file the shift wraps into
+        };
+
+        Directions BDirections
+            ,      RDirections;
+
+        inline __m256i shift (__m256i v, __m256i l, __m256i r)
+        {
+            return _mm256_or_si256 (_mm256_sllv_epi64 (v, l), _mm256_srlv_epi64 (v, r));
+        }
+
+        // fill_attacks() returns the attacks of the slider in the four directions by
+        // a Kogge-Stone occluded fill over the empty squares, OR-ed across the lanes.
+        inline Bitboard fill_attacks (const Directions &dirs, Square s, __m256i empty)
+        {
+            __m256i slider = _mm256_set1_epi64x (i64 (Square_bb[s]));
+            empty  = _mm256_and_si256 (empty, dirs.wrap);
+            slider = _mm256_or_si256  (slider, _mm256_and_si256 (empty, shift (slider, dirs.lshift[0], dirs.rshift[0])));
+            empty  = _mm256_and_si256 (empty, shift (empty, dirs.lshift[0], dirs.rshift[0]));
+            slider = _mm256_or_si256  (slider, _mm256_and_si256 (empty, shift (slider, dirs.lshift[1], dirs.rshift[1])));
+            empty  = _mm256_and_si256 (empty, shift (empty, dirs.lshift[1], dirs.rshift[1]));
+            slider = _mm256_or_si256  (slider, _mm256_and_si256 (empty, shift (slider, dirs.lshift[2], dirs.rshift[2])));
+            slider = _mm256_and_si256 (shift (slider, dirs.lshift[0], dirs.rshift[0]), dirs.wrap);
+
+            __m128i attacks = _mm_or_si128 (_mm256_castsi256_si128 (slider), _mm256_extracti128_si256 (slider, 1));
+            attacks = _mm_or_si128 (attacks, _mm_unpackhi_epi64 (attacks, attacks));
+            return Bitboard (_mm_cvtsi128_si64 (attacks));
+        }
+
+        void initialize_directions (Directions &dirs, const i08 deltas[4], const Bitboard wraps[4])
+        {
+            for (u08 step = 0; step < 3; ++step)
+            {
+                i64 l[4], r[4];
+                for (u08 i = 0; i < 4; ++i)
+                {
+                    l[i] = deltas[i] > 0 ? +deltas[i] << step : 64;
+                    r[i] = deltas[i] < 0 ? -deltas[i] << step : 64;
+                }
+                dirs.lshift[step] = _mm256_setr_epi64x (l[0], l[1], l[2], l[3]);
+                dirs.rshift[step] = _mm256_setr_epi64x (r[0], r[1], r[2], r[3]);
+            }
+            dirs.wrap = _mm256_setr_epi64x (i64 (wraps[0]), i64 (wraps[1]), i64 (wraps[2]), i64 (wraps[3]));
+        }
+
+        void initialize_fills ()
+        {
+            const i08      BDeltas[4] = { +9, +7, -7, -9 };
+            const i08      RDeltas[4] = { +8, -8, +1, -1 };
+            const Bitboard BWraps [4] = { FA_bb_, FH_bb_, FA_bb_, FH_bb_ };
+            const Bitboard RWraps [4] = { ~U64 (0), ~U64 (0), FA_bb_, FH_bb_ };
+            initialize_directions (BDirections, BDeltas, BWraps);
+            initialize_directions (RDirections, RDeltas, RWraps);
+        }
+
+#else
+
+        // SSE2 has no variable shifts, so the lanes hold the bitboards of different
+        // sliders instead, all filled in the same direction at once.
+#   if defined(FILL_SSE2)
+
+        typedef __m128i Lanes;
+        const u08 LANES = 2;
+
+        inline Lanes load  (const Bitboard *bb)   { return _mm_loadu_si128 ((const __m128i*) bb); }
+        inline void  store (Bitboard *bb, Lanes v) { _mm_storeu_si128 ((__m128i*) bb, v); }
+        inline Lanes broadcast (Bitboard bb)       { const Bitboard b[LANES] = { bb, bb }; return load (b); }
+        inline Lanes and_lanes (Lanes a, Lanes b)  { return _mm_and_si128 (a, b); }
+        inline Lanes or_lanes  (Lanes a, Lanes b)  { return _mm_or_si128  (a, b); }
+        template<i08 S, bool LEFT = (S > 0)>
+        struct Shift           { static inline Lanes apply (Lanes v) { return _mm_slli_epi64 (v, S); } };
+        template<i08 S>
+        struct Shift<S, false> { static inline Lanes apply (Lanes v) { return _mm_srli_epi64 (v, -S); } };
+
+#   else
+
+        typedef Bitboard Lanes;
+        const u08 LANES = 1;
+
+        inline Lanes load  (const Bitboard *bb)   { return *bb; }
+        inline void  store (Bitboard *bb, Lanes v) { *bb = v; }
+        inline Lanes broadcast (Bitboard bb)       { return bb; }
+        inline Lanes and_lanes (Lanes a, Lanes b)  { return a & b; }
+        inline Lanes or_lanes  (Lanes a, Lanes b)  { return a | b; }
+        template<i08 S, bool LEFT = (S > 0)>
+        struct Shift           { static inline Lanes apply (Lanes v) { return v << S; } };
+        template<i08 S>
+        struct Shift<S, false> { static inline Lanes apply (Lanes v) { return v >> -S; } };
+
+#   endif
+
+        template<i08 S>
+        inline Lanes shift (Lanes v) { return Shift<S>::apply (v); }
+
+        template<i08 S>
+        // fill_attacks() returns the attacks in the direction of the shift by
+        // a Kogge-Stone occluded fill of the sliders over the empty squares.
+        // 'wrap' clears the file the shift wraps into (all ones for vertical shifts).
+        inline Lanes fill_attacks (Lanes sliders, Lanes empty, Lanes wrap)
+        {
+            empty   = and_lanes (empty, wrap);
+            sliders = or_lanes  (sliders, and_lanes (empty, shift<1*S> (sliders)));
+            empty   = and_lanes (empty, shift<1*S> (empty));
+            sliders = or_lanes  (sliders, and_lanes (empty, shift<2*S> (sliders)));
+            empty   = and_lanes (empty, shift<2*S> (empty));
+            sliders = or_lanes  (sliders, and_lanes (empty, shift<4*S> (sliders)));
+            return and_lanes (shift<S> (sliders), wrap);
+        }
+
+        template<PieceT PT>
+        inline Lanes fill_attacks (Lanes sliders, Lanes empty);
+
+        template<>
+        inline Lanes fill_attacks<BSHP> (Lanes sliders, Lanes empty)
+        {
+            const Lanes not_a = broadcast (FA_bb_)
+                ,       not_h = broadcast (FH_bb_);
+            return or_lanes (or_lanes (fill_attacks<+9> (sliders, empty, not_a), fill_attacks<+7> (sliders, empty, not_h))
+                           , or_lanes (fill_attacks<-7> (sliders, empty, not_a), fill_attacks<-9> (sliders, empty, not_h)));
+        }
+        template<>
+        inline Lanes fill_attacks<ROOK> (Lanes sliders, Lanes empty)
+        {
+            const Lanes all   = broadcast (~U64 (0))
+                ,       not_a = broadcast (FA_bb_)
+                ,       not_h = broadcast (FH_bb_);
+            return or_lanes (or_lanes (fill_attacks<+8> (sliders, empty, all  ), fill_attacks<-8> (sliders, empty, all  ))
+                           , or_lanes (fill_attacks<+1> (sliders, empty, not_a), fill_attacks<-1> (sliders, empty, not_h)));
+        }
+        template<>
+        inline Lanes fill_attacks<QUEN> (Lanes sliders, Lanes empty)
+        {
+            return or_lanes (fill_attacks<BSHP> (sliders, empty), fill_attacks<ROOK> (sliders, empty));
+        }
+
+        void initialize_fills () {}
+
+#endif
+
+    }
+
+    template<PieceT PT>
+    // slider_attacks() computes the attacks of every slider of the list (terminated by SQ_NO)
+    u08 slider_attacks (const Square *sqs, Bitboard occ, Bitboard attacks[])
+    {
+#if defined(FILL_AVX2)
+
+        const __m256i empty = _mm256_set1_epi64x (i64 (~occ));
+
+        u08 n = 0;
+        Square s;
+        while ((s = sqs[n]) != SQ_NO)
+        {
+            attacks[n++] =
+                (BSHP == PT) ? fill_attacks (BDirections, s, empty) :
+                (ROOK == PT) ? fill_attacks (RDirections, s, empty) :
+                fill_attacks (BDirections, s, empty) | fill_attacks (RDirections, s, empty);
+        }
+        return n;
+
+#else
+
+        const Lanes empty = broadcast (~occ);
+
+        u08 n = 0;
+        while (sqs[n] != SQ_NO)
+        {
+            Bitboard sliders[LANES];
+            u08 k = 0;
+            for (; k < LANES && sqs[n + k] != SQ_NO; ++k) sliders[k] = Square_bb[sqs[n + k]];
+            for (u08 i = k; i < LANES; ++i)                sliders[i] = U64 (0);
+
+            Bitboard result[LANES];
+            store (result, fill_attacks<PT> (load (sliders), empty));
+            for (u08 i = 0; i < k; ++i) attacks[n + i] = result[i];
+            n += k;
         }
+        return n;
 
+#endif
+    }
+
+    // Explicit template instantiations
+    // --------------------------------
+    template u08 slider_attacks<BSHP> (const Square *sqs, Bitboard occ, Bitboard attacks[]);
+    template u08 slider_attacks<ROOK> (const Square *sqs, Bitboard occ, Bitboard attacks[]);
+    template u08 slider_attacks<QUEN> (const Square *sqs, Bitboard occ, Bitboard attacks[]);
+
+    u32 magic_table_size ()
+    {
+        return sizeof (BTable_bb) + sizeof (RTable_bb)
+             + sizeof (BAttack_bb) + sizeof (RAttack_bb)
+             + sizeof (BMask_bb) + sizeof (RMask_bb)
+             + sizeof (BMagic_bb) + sizeof (RMagic_bb)
+             + sizeof (BShift) + sizeof (RShift)
+#ifdef COMPACT
+             + sizeof (DiagLine_bb) + sizeof (FileSpread_bb)
+#endif
+             ;
+    }
+
+    u32 attack_table_size ()
+    {
+        return
+#if defined(SLIDERS_KG)
+            Kindergarten::table_size ()
+#elif defined(SLIDERS_SHERWIN)
+            Sherwin::table_size ()
+#else
+            magic_table_size ()
+#endif
+            + sizeof (PawnAttacks) + sizeof (PieceAttacks)
+            + sizeof (Between_bb) + sizeof (LineRay_bb);
     }
 
     void initialize ()
@@ -299,6 +604,14 @@ namespace BitBoard {
         }
 
         initialize_sliding ();
+        initialize_fills ();
+
+        // NOTE:: the selected engine must be ready before computing the lines below
+#if defined(SLIDERS_KG)
+        Kindergarten::initialize ();
+#elif defined(SLIDERS_SHERWIN)
+        Sherwin::initialize ();
+#endif
 
         for (Square s1 = SQ_A1; s1 <= SQ_H8; ++s1)
         {
@@ -7,6 +7,10 @@
 
 #include "Type.h"
 
+#ifdef BMI2
+#   include <immintrin.h> // For _pext_u64
+#endif
+
 namespace BitBoard {
 
     const Bitboard FA_bb = U64 (0x0101010101010101);
@@ -161,8 +165,23 @@ namespace BitBoard {
     CACHE_ALIGN(64) extern Bitboard PawnAttacks[CLR_NO][SQ_NO];
     CACHE_ALIGN(64) extern Bitboard PieceAttacks[NONE][SQ_NO];
 
-    CACHE_ALIGN(64) extern Bitboard *BAttack_bb[SQ_NO];
-    CACHE_ALIGN(64) extern Bitboard *RAttack_bb[SQ_NO];
+#ifdef COMPACT
+    // Compact magic tables have 16-bit entries, a byte per line of the attacks:
+    // the bits of the (anti-)diagonal or of the rank by file, of the file by rank.
+    // A byte is expanded by copying it to all the ranks (multiplication) masked
+    // by the line, or by the spread of the byte along the A-file for the file.
+    typedef u16      AttackEntry;
+
+    // [0] diagonal A1-H8 direction, [1] anti-diagonal A8-H1 direction through the square
+    CACHE_ALIGN(64) extern Bitboard DiagLine_bb[2][SQ_NO];
+    // Byte of ranks spread along the A-file
+    CACHE_ALIGN(64) extern Bitboard FileSpread_bb[256];
+#else
+    typedef Bitboard AttackEntry;
+#endif
+
+    CACHE_ALIGN(64) extern AttackEntry *BAttack_bb[SQ_NO];
+    CACHE_ALIGN(64) extern AttackEntry *RAttack_bb[SQ_NO];
 
     CACHE_ALIGN(64) extern Bitboard    BMask_bb[SQ_NO];
     CACHE_ALIGN(64) extern Bitboard    RMask_bb[SQ_NO];
@@ -325,17 +344,57 @@ namespace BitBoard {
     INLINE Bitboard attacks_bb<KING> (Square s, Bitboard) { return PieceAttacks[KING][s]; }
     // --------------------------------
 
+    // Slider attack engines other than the magic (or PEXT) lookup below, all compiled in
+    // to compare them ("bench sliders"), the one selected at build time (sliders=kg or
+    // sliders=sherwin) backs attacks_bb<BSHP/ROOK/QUEN> in place of the magic lookup.
+    namespace Kindergarten {
+
+        extern void initialize ();
+        // Bytes of the tables
+        extern u32  table_size ();
+
+        template<PieceT PT>
+        extern Bitboard attacks_bb (Square s, Bitboard occ);
+        template<> Bitboard attacks_bb<BSHP> (Square s, Bitboard occ);
+        template<> Bitboard attacks_bb<ROOK> (Square s, Bitboard occ);
+        template<> Bitboard attacks_bb<QUEN> (Square s, Bitboard occ);
+
+    }
+
+    namespace Sherwin {
+
+        extern void initialize ();
+        // Bytes of the tables
+        extern u32  table_size ();
+
+        template<PieceT PT>
+        extern Bitboard attacks_bb (Square s, Bitboard occ);
+        template<> Bitboard attacks_bb<BSHP> (Square s, Bitboard occ);
+        template<> Bitboard attacks_bb<ROOK> (Square s, Bitboard occ);
+        template<> Bitboard attacks_bb<QUEN> (Square s, Bitboard occ);
+
+    }
+
+    // Bytes of the magic (or PEXT) tables
+    extern u32 magic_table_size ();
+    // Bytes of all the attack tables used by the search (selected slider engine included)
+    extern u32 attack_table_size ();
+
     template<PieceT PT>
     // Function 'magic_index(s, occ)' for computing index for sliding attack bitboards.
     // Function 'attacks_bb(s, occ)' takes a square and a bitboard of occupied squares as input,
     // and returns a bitboard representing all squares attacked by PT (BISHOP or ROOK) on the given square.
+    // With BMI2 the index is the occupancy of the mask extracted by PEXT, one instruction
+    // in place of the multiply-shift (the tables are the same size).
     extern INLINE u16 magic_index   (Square s, Bitboard occ);
 
     template<>
     INLINE u16 magic_index   <BSHP> (Square s, Bitboard occ)
     {
 
-#ifdef _64BIT
+#if defined(BMI2)
+        return u16 (_pext_u64 (occ, BMask_bb[s]));
+#elif defined(_64BIT)
         return u16 (((occ & BMask_bb[s]) * BMagic_bb[s]) >> BShift[s]);
 #else
         u32 lo = (u32 (occ >>  0) & u32 (BMask_bb[s] >>  0)) * u32 (BMagic_bb[s] >>  0);
@@ -349,7 +408,9 @@ namespace BitBoard {
     INLINE u16 magic_index   <ROOK> (Square s, Bitboard occ)
     {
 
-#ifdef _64BIT
+#if defined(BMI2)
+        return u16 (_pext_u64 (occ, RMask_bb[s]));
+#elif defined(_64BIT)
         return u16 (((occ & RMask_bb[s]) * RMagic_bb[s]) >> RShift[s]);
 #else
         u32 lo = (u32 (occ >>  0) & u32 (RMask_bb[s] >>  0)) * u32 (RMagic_bb[s] >>  0);
@@ -359,19 +420,68 @@ namespace BitBoard {
 
     }
 
+    template<PieceT PT>
+    // Attacks of the BISHOP or the ROOK with occupancy looked up in the magic (or PEXT) tables
+    INLINE Bitboard magic_attacks_bb (Square s, Bitboard occ);
+
+    template<>
+    INLINE Bitboard magic_attacks_bb<BSHP> (Square s, Bitboard occ)
+    {
+#ifdef COMPACT
+        u16 e = BAttack_bb[s][magic_index<BSHP> (s, occ)];
+        return ((Bitboard (e & 0xFF) * FA_bb) & DiagLine_bb[0][s])
+            |  ((Bitboard (e >>   8) * FA_bb) & DiagLine_bb[1][s]);
+#else
+        return BAttack_bb[s][magic_index<BSHP> (s, occ)];
+#endif
+    }
+    template<>
+    INLINE Bitboard magic_attacks_bb<ROOK> (Square s, Bitboard occ)
+    {
+#ifdef COMPACT
+        u16 e = RAttack_bb[s][magic_index<ROOK> (s, occ)];
+        return (Bitboard (e & 0xFF) << (s & 0x38))
+            |  (FileSpread_bb[e >> 8] << _file (s));
+#else
+        return RAttack_bb[s][magic_index<ROOK> (s, occ)];
+#endif
+    }
+
+#if defined(SLIDERS_KG)
+
+    template<>
+    INLINE Bitboard attacks_bb<BSHP> (Square s, Bitboard occ) { return Kindergarten::attacks_bb<BSHP> (s, occ); }
+    template<>
+    INLINE Bitboard attacks_bb<ROOK> (Square s, Bitboard occ) { return Kindergarten::attacks_bb<ROOK> (s, occ); }
+    template<>
+    INLINE Bitboard attacks_bb<QUEN> (Square s, Bitboard occ) { return Kindergarten::attacks_bb<QUEN> (s, occ); }
+
+#elif defined(SLIDERS_SHERWIN)
+
+    template<>
+    INLINE Bitboard attacks_bb<BSHP> (Square s, Bitboard occ) { return Sherwin::attacks_bb<BSHP> (s, occ); }
+    template<>
+    INLINE Bitboard attacks_bb<ROOK> (Square s, Bitboard occ) { return Sherwin::attacks_bb<ROOK> (s, occ); }
+    template<>
+    INLINE Bitboard attacks_bb<QUEN> (Square s, Bitboard occ) { return Sherwin::attacks_bb<QUEN> (s, occ); }
+
+#else
+
     template<>
     // Attacks of the BISHOP with occupancy
-    INLINE Bitboard attacks_bb<BSHP> (Square s, Bitboard occ) { return BAttack_bb[s][magic_index<BSHP> (s, occ)]; }
+    INLINE Bitboard attacks_bb<BSHP> (Square s, Bitboard occ) { return magic_attacks_bb<BSHP> (s, occ); }
     template<>
     // Attacks of the ROOK with occupancy
-    INLINE Bitboard attacks_bb<ROOK> (Square s, Bitboard occ) { return RAttack_bb[s][magic_index<ROOK> (s, occ)]; }
+    INLINE Bitboard attacks_bb<ROOK> (Square s, Bitboard occ) { return magic_attacks_bb<ROOK> (s, occ); }
     template<>
     // QUEEN Attacks with occ
     INLINE Bitboard attacks_bb<QUEN> (Square s, Bitboard occ)
     {
-        return BAttack_bb[s][magic_index<BSHP> (s, occ)]
-            |  RAttack_bb[s][magic_index<ROOK> (s, occ)];
+        return magic_attacks_bb<BSHP> (s, occ)
+            |  magic_attacks_bb<ROOK> (s, occ);
     }
+
+#endif
     // --------------------------------
 
     // Piece attacks from square
@@ -398,6 +508,12 @@ namespace BitBoard {
              : U64 (0);
     }
 
+    template<PieceT PT>
+    // Attacks of all the sliders of the list (terminated by SQ_NO) with occupancy,
+    // computed together by SIMD occluded fills instead of one lookup per square.
+    // Returns the number of sliders.
+    extern u08 slider_attacks (const Square *sqs, Bitboard occ, Bitboard attacks[]);
+
     extern void initialize ();
 
 #ifndef NDEBUG
@@ -1,6 +1,7 @@
 #include "Endgame.h"
 
 #include <algorithm>
+#include <cstring>
 
 #include "Position.h"
 #include "BitBoard.h"
@@ -95,14 +96,15 @@ namespace EndGame {
             return Position (fen).matl_key ();
         }
 
-        template<class M>
-        inline void delete_endgame (const typename M::value_type &p) { delete p.second; }
-
     } // namespace
 
+    const Endgames *EndgameTable = NULL;
+
     // Endgames members definitions
     Endgames::Endgames ()
     {
+        memset (_table, 0, sizeof (_table));
+
         add<KPK>     ("KPK");
         add<KNNK>    ("KNNK");
         add<KBNK>    ("KBNK");
@@ -125,15 +127,46 @@ namespace EndGame {
 
     Endgames::~Endgames ()
     {
-        for_each (m1.begin (), m1.end (), delete_endgame<M1>);
-        for_each (m2.begin (), m2.end (), delete_endgame<M2>);
+        for (u16 i = 0; i < SIZE; ++i)
+        {
+            delete _table[i].eval_func;
+            delete _table[i].scale_func;
+        }
+    }
+
+    Endgames::Entry& Endgames::slot (Key key)
+    {
+        u16 i = u16 (key) & (SIZE - 1);
+        while (_table[i].key != key && _table[i].key != U64 (0))
+        {
+            i = (i + 1) & (SIZE - 1);
+        }
+        return _table[i];
     }
 
     template<EndgameT E>
     void Endgames::add (const string &code)
     {
-        map ((Endgame<E>*) 0)[key (code, WHITE)] = new Endgame<E> (WHITE);
-        map ((Endgame<E>*) 0)[key (code, BLACK)] = new Endgame<E> (BLACK);
+        for (Color c = WHITE; c <= BLACK; ++c)
+        {
+            Key k    = key (code, c);
+            Entry &e = slot (k);
+            ASSERT (NULL == func (e, (Endgame<E>*) 0));
+            e.key = k;
+            func (e, (Endgame<E>*) 0) = new Endgame<E> (c);
+        }
+    }
+
+    void initialize ()
+    {
+        deinitialize ();
+        EndgameTable = new Endgames ();
+    }
+
+    void deinitialize ()
+    {
+        delete EndgameTable;
+        EndgameTable = NULL;
     }
 
     template<>
@@ -5,7 +5,6 @@
 #ifndef _ENDGAME_H_INC_
 #define _ENDGAME_H_INC_
 
-#include <map>
 #include <string>
 
 #include "Type.h"
@@ -90,20 +89,36 @@ namespace EndGame {
 
     };
 
-    // Endgames class stores in two std::map the pointers to endgame evaluation
-    // and scaling base objects. Then we use polymorphism to invoke the actual
-    // endgame function calling its operator() that is virtual.
+    // Endgames class stores the pointers to endgame evaluation and scaling base objects
+    // in a flat open-addressed table indexed by the material key (linear probing).
+    // The table is sparse and small so a probe usually reads a single cache line.
+    // Then we use polymorphism to invoke the actual endgame function calling
+    // its operator() that is virtual.
+    // It is read-only once built, one table is shared by all the threads.
     class Endgames
     {
 
-        typedef std::map<Key, EndgameBase<eg_fun<0>::type>*> M1;
-        typedef std::map<Key, EndgameBase<eg_fun<1>::type>*> M2;
+    private:
+
+        struct Entry
+        {
+            Key                          key;
+            EndgameBase<eg_fun<0>::type> *eval_func;
+            EndgameBase<eg_fun<1>::type> *scale_func;
+        };
+
+        // Power of 2, at least 4 times the number of keys
+        static const u16 SIZE = 128;
 
-        M1 m1;
-        M2 m2;
+        Entry _table[SIZE];
 
-        inline M1& map (M1::mapped_type) { return m1; }
-        inline M2& map (M2::mapped_type) { return m2; }
+        inline EndgameBase<eg_fun<0>::type>*& func (Entry &e, EndgameBase<eg_fun<0>::type>*) { return e.eval_func; }
+        inline EndgameBase<eg_fun<1>::type>*& func (Entry &e, EndgameBase<eg_fun<1>::type>*) { return e.scale_func; }
+        inline EndgameBase<eg_fun<0>::type>*  func (const Entry &e, EndgameBase<eg_fun<0>::type>*) const { return e.eval_func; }
+        inline EndgameBase<eg_fun<1>::type>*  func (const Entry &e, EndgameBase<eg_fun<1>::type>*) const { return e.scale_func; }
+
+        // Entry of the key, or the empty one where to insert it
+        Entry& slot (Key key);
 
         template<EndgameT E>
         void add (const std::string &code);
@@ -114,13 +129,24 @@ namespace EndGame {
        ~Endgames ();
 
         template<class T>
-        inline T probe (Key key, T &eg)
+        inline T probe (Key key, T &eg) const
         {
-            return eg = (map (eg).count (key) ? map (eg)[key] : NULL);
+            for (u16 i = u16 (key) & (SIZE - 1); ; i = (i + 1) & (SIZE - 1))
+            {
+                const Entry &e = _table[i];
+                if (e.key == key) return eg = func (e, eg);
+                if (e.key == U64 (0)) return eg = NULL;
+            }
         }
 
     };
 
+    // Endgames shared by all the threads, built by initialize()
+    extern const Endgames *EndgameTable;
+
+    extern void initialize ();
+    extern void deinitialize ();
+
 }
 
 #endif // _ENDGAME_H_INC_
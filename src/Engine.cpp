@@ -7,7 +7,9 @@
 #include "BitBases.h"
 #include "Pawns.h"
 #include "Material.h"
+#include "Endgame.h"
 #include "Evaluator.h"
+#include "Network.h"
 #include "Searcher.h"
 #include "Transposition.h"
 #include "TB_Syzygy.h"
@@ -74,7 +76,9 @@ namespace Engine {
         oss << " w32";
 #endif
 
-#ifdef POPCNT
+#if defined(BMI2)
+        oss << "-bmi2";
+#elif defined(POPCNT)
         oss << "-modern";
 #endif
 
@@ -95,6 +99,10 @@ namespace Engine {
         cout << "info string POPCNT available." << endl;
 #endif
 
+#ifdef BMI2
+        cout << "info string BMI2 available." << endl;
+#endif
+
 #ifdef LPAGES
         cout << "info string LARGE PAGES available." << endl;
         MemoryHandler::initialize ();
@@ -107,7 +115,10 @@ namespace Engine {
         BitBases ::initialize ();
         Searcher ::initialize ();
         Pawns    ::initialize ();
+        EndGame  ::initialize ();
+        Material ::initialize ();
         Evaluator::initialize ();
+        Network  ::initialize ();
         Threadpool.initialize ();
         
         TT.resize (i32 (*(Options["Hash"])), true);
@@ -133,6 +144,8 @@ namespace Engine {
         UCI::stop ();
         
         Threadpool.deinitialize ();
+        Material::deinitialize ();
+        EndGame::deinitialize ();
         UCI::deinitialize ();
 
         ::exit (code);
@@ -3,12 +3,14 @@
 #include <iomanip>
 #include <sstream>
 #include <algorithm>
+#include <cstring>
 
 #include "BitBoard.h"
 #include "BitCount.h"
 #include "Position.h"
 #include "Material.h"
 #include "Pawns.h"
+#include "Network.h"
 #include "Thread.h"
 #include "UCI.h"
 
@@ -64,16 +66,11 @@ namespace Evaluator {
 
         namespace Tracing {
 
-            // Used for tracing
-            enum TermT
-            {
-                PST = 6, IMBALANCE, MOBILITY, THREAT, PASSED, SPACE, TOTAL, TERM_NO
-            };
-
-            Score       Terms[CLR_NO][TERM_NO];
+            // Used for tracing, per thread as batch evaluations trace in parallel
+            THREAD_LOCAL Score       Terms[CLR_NO][TERM_NO];
 
-            EvalInfo    Evalinfo;
-            ScaleFactor Scalefactor;
+            THREAD_LOCAL EvalInfo    Evalinfo;
+            THREAD_LOCAL ScaleFactor Scalefactor;
 
             inline double value_to_cp (const Value &value) { return double (value) / double (VALUE_MG_PAWN); }
 
@@ -277,8 +274,17 @@ namespace Evaluator {
         // scores, indexed by color and by a calculated integer number.
         Score KingDanger[CLR_NO][100];
 
+        // The king danger depends on the root color, so the cached evaluations
+        // of the searches from the black side are keyed apart
+        const Key ROOT_BLACK_KEY = U64 (0x9D39247E33776D41);
+
+        // Lazy evaluation margin, 0 disables the lazy exit
+        Value LazyMargin = VALUE_ZERO;
+        // A lazy exit is verified with the full evaluation once in LAZY_CHECK_PERIOD
+        const u64 LAZY_CHECK_PERIOD = 64;
+
         template<bool TRACE>
-        Value do_evaluate   (const Position &pos);
+        Value do_evaluate   (const Position &pos, Value alpha, Value beta, bool &lazy);
 
         template<Color C>
         void init_eval_info (const Position &pos, EvalInfo &ei);
@@ -309,7 +315,7 @@ namespace Evaluator {
         // --------------
 
         template<bool TRACE>
-        inline Value do_evaluate (const Position &pos)
+        inline Value do_evaluate (const Position &pos, Value alpha, Value beta, bool &lazy)
         {
             ASSERT (pos.checkers () == U64(0));
 
@@ -324,7 +330,7 @@ namespace Evaluator {
 
             EvalInfo ei;
             // Probe the material hash table
-            ei.mi = Material::probe (pos, thread->material_table, thread->endgames);
+            ei.mi = Material::probe (pos, thread->material_table);
             score += ei.mi->material_score ();
 
             // If we have a specialized evaluation function for the current material
@@ -338,6 +344,20 @@ namespace Evaluator {
             ei.pi = Pawns::probe (pos, thread->pawns_table);
             score += apply_weight (ei.pi->pawn_score (), Weights[PawnStructure]);
 
+            // Lazy exit if material, piece-square and pawn structure are already
+            // far enough outside of the window, skip all the attack based terms.
+            if (!TRACE && LazyMargin != VALUE_ZERO)
+            {
+                Value lazy_value = interpolate (score, ei.mi->game_phase (), SCALE_FACTOR_NORMAL);
+                if (BLACK == pos.active ()) lazy_value = -lazy_value;
+
+                if (lazy_value - LazyMargin >= beta || lazy_value + LazyMargin <= alpha)
+                {
+                    lazy = true;
+                    return lazy_value;
+                }
+            }
+
             // Initialize attack and king safety bitboards
             init_eval_info<WHITE> (pos, ei);
             init_eval_info<BLACK> (pos, ei);
@@ -416,8 +436,8 @@ namespace Evaluator {
             // In case of tracing add all single evaluation contributions for both white and black
             if (TRACE)
             {
-                Tracing::add_term (Tracing::PST, pos.psq_score ());
-                Tracing::add_term (Tracing::IMBALANCE, ei.mi->material_score ());
+                Tracing::add_term (PST, pos.psq_score ());
+                Tracing::add_term (IMBALANCE, ei.mi->material_score ());
                 Tracing::add_term (PAWN, ei.pi->pawn_score ());
 
                 Score scr[CLR_NO] =
@@ -426,11 +446,11 @@ namespace Evaluator {
                     ei.mi->space_weight () * evaluate_space<BLACK> (pos, ei)
                 };
 
-                Tracing::add_term (Tracing::SPACE
+                Tracing::add_term (SPACE
                     , apply_weight (scr[WHITE], Weights[Space])
                     , apply_weight (scr[BLACK], Weights[Space]));
 
-                Tracing::add_term (Tracing::TOTAL, score);
+                Tracing::add_term (TOTAL, score);
 
                 Tracing::Evalinfo    = ei;
                 Tracing::Scalefactor = scale_factor;
@@ -519,15 +539,45 @@ namespace Evaluator {
             ei.attacked_by[C][PT] = U64 (0);
 
             const Square *pl = pos.list<PT> (C);
+
+#if !defined(ATTACKMAP) && defined(FILLATTACKS)
+            // Find attacked squares of all the sliders at once, including x-ray attacks for bishops and rooks
+            Bitboard slider_attacks_list[16];
+            if (NIHT != PT)
+            {
+                slider_attacks<(BSHP == PT) ? BSHP : (ROOK == PT) ? ROOK : QUEN> (pl,
+                    (BSHP == PT) ? pos.pieces () ^ pos.pieces (C, QUEN, BSHP) :
+                    (ROOK == PT) ? pos.pieces () ^ pos.pieces (C, QUEN, ROOK) :
+                    pos.pieces (), slider_attacks_list);
+            }
+            const Bitboard *slider_attacks_itr = slider_attacks_list;
+#endif
+
             Square s;
             while ((s = *pl++) != SQ_NO)
             {
+#if defined(ATTACKMAP)
+                // Find attacked squares from the attack maps, x-ray attacks for bishops and rooks
+                // are recomputed only if a friend queen or same slider stands on their rays
+                Bitboard attacks = pos.attacks_from (s);
+                if (BSHP == PT && (attacks & pos.pieces (C, QUEN, BSHP)))
+                {
+                    attacks = attacks_bb<BSHP> (s, pos.pieces () ^ pos.pieces (C, QUEN, BSHP));
+                }
+                if (ROOK == PT && (attacks & pos.pieces (C, QUEN, ROOK)))
+                {
+                    attacks = attacks_bb<ROOK> (s, pos.pieces () ^ pos.pieces (C, QUEN, ROOK));
+                }
+#elif defined(FILLATTACKS)
+                Bitboard attacks = (NIHT == PT) ? PieceAttacks[NIHT][s] : *slider_attacks_itr++;
+#else
                 // Find attacked squares, including x-ray attacks for bishops and rooks
                 Bitboard attacks =
                     (BSHP == PT) ? attacks_bb<BSHP> (s, pos.pieces () ^ pos.pieces (C, QUEN, BSHP)) :
                     (ROOK == PT) ? attacks_bb<ROOK> (s, pos.pieces () ^ pos.pieces (C, QUEN, ROOK)) :
                     (QUEN == PT) ? attacks_bb<BSHP> (s, pos.pieces ()) | attacks_bb<ROOK> (s, pos.pieces ()) :
                     (NIHT == PT) ? PieceAttacks[NIHT][s] : PieceAttacks[KING][s];
+#endif
 
                 if (ei.pinned_pieces[C] & s)
                 {
@@ -714,7 +764,7 @@ namespace Evaluator {
 
             if (TRACE)
             {
-                Tracing::Terms[C][Tracing::MOBILITY] = apply_weight (mobility[C], Weights[Mobility]);
+                Tracing::Terms[C][MOBILITY] = apply_weight (mobility[C], Weights[Mobility]);
             }
 
             return score;
@@ -868,7 +918,7 @@ namespace Evaluator {
 
             if (TRACE)
             {
-                Tracing::Terms[C][Tracing::THREAT] = score;
+                Tracing::Terms[C][THREAT] = score;
             }
 
             return score;
@@ -1004,7 +1054,7 @@ namespace Evaluator {
 
             if (TRACE)
             {
-                Tracing::Terms[C][Tracing::PASSED] = apply_weight (score, Weights[PassedPawns]);
+                Tracing::Terms[C][PASSED] = apply_weight (score, Weights[PassedPawns]);
             }
 
             // Add the scores to the middle game and endgame eval
@@ -1090,7 +1140,8 @@ namespace Evaluator {
             {
                 memset (Terms, 0, sizeof (Terms));
 
-                Value value = do_evaluate<true> (pos);
+                bool lazy = false;
+                Value value = do_evaluate<true> (pos, -VALUE_INFINITE, +VALUE_INFINITE, lazy);
 
                 stringstream ss;
 
@@ -1117,6 +1168,10 @@ namespace Evaluator {
                     << setw (6) << (100.0 * (1.0 - Evalinfo.mi->game_phase () / 128.0)) << "% * "
                     << setw (6) << (100.0 * Scalefactor) / SCALE_FACTOR_NORMAL << "% EG.\n"
                     << "Total evaluation: " << value_to_cp (value);
+                if (Network::Active)
+                {
+                    ss  << "\nNetwork evaluation: " << value_to_cp (Network::evaluate (pos));
+                }
 
                 return ss.str ();
             }
@@ -1126,9 +1181,99 @@ namespace Evaluator {
     // evaluate() is the main evaluation function. It always computes two
     // values, an endgame score and a middle game score, and interpolates
     // between them based on the remaining material.
-    Value evaluate (const Position &pos)
+    // The evaluation cache of the thread is probed first (by the position
+    // and the root color), only the full evaluations are cached, never the lazy ones.
+    // The network evaluation replaces all of it when it is active.
+    Value evaluate (const Position &pos, Value alpha, Value beta, bool *lazy_exit)
     {
-        return do_evaluate<false> (pos);
+        if (lazy_exit != NULL) *lazy_exit = false;
+
+        Thread *thread = pos.thread ();
+
+        Key key = pos.posi_key () ^ (BLACK == Searcher::RootColor ? ROOT_BLACK_KEY : U64 (0));
+        Cache &cache   = thread->eval_cache;
+        CacheEntry *ce = NULL;
+        if (cache.enabled ())
+        {
+            ce = cache[key];
+            ++cache.probes;
+            if (ce->key == u32 (key >> 32) && ce->value != VALUE_NONE)
+            {
+                ++cache.hits;
+                return ce->value;
+            }
+        }
+
+        Value value;
+        if (Network::Active)
+        {
+            value = Network::evaluate (pos);
+            if (ce != NULL)
+            {
+                ce->key   = u32 (key >> 32);
+                ce->value = value;
+            }
+            return value;
+        }
+
+        LazyStats &stats = thread->lazy_stats;
+        ++stats.evals;
+
+        bool lazy = false;
+        value = do_evaluate<false> (pos, alpha, beta, lazy);
+        if (lazy)
+        {
+            ++stats.exits;
+            // Verify once in a while the lazy exit, it is wrong if the full
+            // evaluation is on the other side of the window bound it skipped.
+            if (stats.exits % LAZY_CHECK_PERIOD == 0)
+            {
+                ++stats.checks;
+                bool full_lazy = false;
+                Value full = do_evaluate<false> (pos, -VALUE_INFINITE, +VALUE_INFINITE, full_lazy);
+                if ((value >= beta) ? (full < beta) : (full > alpha))
+                {
+                    ++stats.wrongs;
+                }
+            }
+            if (lazy_exit != NULL) *lazy_exit = true;
+            return value;
+        }
+
+        if (ce != NULL)
+        {
+            ce->key   = u32 (key >> 32);
+            ce->value = value;
+        }
+        return value;
+    }
+
+    void Cache::resize (u32 size_kb)
+    {
+        u64 entries = 0;
+        if (size_kb != 0)
+        {
+            entries = 1;
+            while (2 * entries * sizeof (CacheEntry) <= (u64 (size_kb) << 10))
+            {
+                entries *= 2;
+            }
+        }
+
+        if (entries != _table.size ())
+        {
+            vector<CacheEntry> (entries).swap (_table);
+            _mask = entries != 0 ? entries - 1 : 0;
+        }
+        clear ();
+    }
+
+    void Cache::clear ()
+    {
+        CacheEntry empty = { 0, VALUE_NONE };
+        fill (_table.begin (), _table.end (), empty);
+        probes = 0;
+        hits   = 0;
     }
 
     // trace() is like evaluate() but instead of a value returns a string suitable
@@ -1139,6 +1284,99 @@ namespace Evaluator {
         return Tracing::do_trace (pos);
     }
 
+    namespace {
+
+        // Batch evaluation work of a thread, a contiguous slice of the positions
+        struct BatchWork
+        {
+            const PackedPosition *positions;
+            Value     *values;
+            EvalTerms *terms;
+            u64        begin
+              ,        end
+              ,        evaluated;
+            Thread    *thread;
+            bool       c960;
+
+            NativeHandle handle;
+        };
+
+        // batch_routine() is the C function which is called on a new native thread
+        // to evaluate the slice of a batch, with the tables of its pool thread.
+        extern "C" { long batch_routine (BatchWork *bw)
+        {
+            Position pos (0);
+            for (u64 i = bw->begin; i < bw->end; ++i)
+            {
+                Value value = VALUE_NONE;
+                if (bw->terms != NULL)
+                {
+                    memset (Tracing::Terms, 0, sizeof (Tracing::Terms));
+                }
+
+                if (   pos.setup (bw->positions[i], bw->thread, bw->c960)
+                    && pos.checkers () == U64 (0))
+                {
+                    // The terms break down the classical evaluation only, while the network
+                    // is active its value is given with the terms left zeroed.
+                    if (bw->terms != NULL && !Network::Active)
+                    {
+                        bool lazy = false;
+                        value = do_evaluate<true> (pos, -VALUE_INFINITE, +VALUE_INFINITE, lazy);
+                    }
+                    else
+                    {
+                        value = evaluate (pos);
+                    }
+                    ++bw->evaluated;
+                }
+
+                bw->values[i] = value;
+                if (bw->terms != NULL)
+                {
+                    memcpy (bw->terms[i].terms, Tracing::Terms, sizeof (Tracing::Terms));
+                }
+            }
+            return 0;
+        } }
+
+    }
+
+    u64 evaluate_batch (const PackedPosition *positions, u64 count, Value *values, EvalTerms *terms, bool c960)
+    {
+        u08 threads = Threadpool.size ();
+        u64 slice   = (count + threads - 1) / threads;
+
+        vector<BatchWork> works (threads);
+        for (u08 t = 0; t < threads; ++t)
+        {
+            BatchWork &bw = works[t];
+            bw.positions = positions;
+            bw.values    = values;
+            bw.terms     = terms;
+            bw.begin     = min (t * slice, count);
+            bw.end       = min (bw.begin + slice, count);
+            bw.evaluated = 0;
+            bw.thread    = Threadpool[t];
+            bw.c960      = c960;
+        }
+
+        // The pool threads are idle, they only lend their tables to the workers
+        for (u08 t = 1; t < threads; ++t)
+        {
+            thread_create (works[t].handle, batch_routine, &works[t]);
+        }
+        batch_routine (&works[0]);
+
+        u64 evaluated = works[0].evaluated;
+        for (u08 t = 1; t < threads; ++t)
+        {
+            thread_join (works[t].handle);
+            evaluated += works[t].evaluated;
+        }
+        return evaluated;
+    }
+
     // initialize() computes evaluation weights from the corresponding UCI parameters
     // and setup king danger tables.
     void initialize ()
@@ -1150,6 +1388,8 @@ namespace Evaluator {
         Weights[Cowardice]     = weight_option ("Cowardice"                , "Cowardice"               , WeightsInternal[Cowardice    ]);
         Weights[Aggressive]    = weight_option ("Aggressive"               , "Aggressive"              , WeightsInternal[Aggressive   ]);
 
+        LazyMargin = Value (i32 (*(Options["Lazy Margin"])) * VALUE_MG_PAWN / 100); // From centipawns
+
         const i32 MaxSlope  = 30;
         const i32 PeakScore = 1280; // 0x500
 
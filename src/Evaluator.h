@@ -5,18 +5,102 @@
 #ifndef _EVALUATOR_H_INC_
 #define _EVALUATOR_H_INC_
 
+#include <vector>
+
 #include "Type.h"
 
 class Position;
+struct PackedPosition;
 
 namespace Evaluator {
 
+    // Evaluation cache entry, the upper 32 bits of the position key
+    // and the evaluation from the side to move point of view.
+    struct CacheEntry
+    {
+        u32   key;
+        Value value;
+    };
+
+    // Evaluation cache, one per thread so no locking is needed.
+    // Positions evaluated again (quiescence, next iterations, TT misses)
+    // read the value instead of running the full evaluation.
+    // A power of 2 number of entries, an empty cache means disabled.
+    class Cache
+    {
+
+    private:
+        std::vector<CacheEntry> _table;
+        u64 _mask;
+
+    public:
+        u64 probes
+          , hits;
+
+        Cache ()
+            : _mask (0)
+            , probes (0)
+            , hits (0)
+        {}
+
+        // resize() sets the size in KB, 0 disables the cache
+        void resize (u32 size_kb);
+        void clear ();
+
+        bool enabled () const { return !_table.empty (); }
+
+        CacheEntry* operator[] (Key k) { return &_table[k & _mask]; }
+
+    };
+
+    // Statistics of the lazy evaluation, one per thread.
+    // A lazy exit is verified against the full evaluation once in a while
+    // to count how often the cheap estimate fell on the wrong side of the window.
+    struct LazyStats
+    {
+        u64 evals   // evaluations computed (cache misses)
+          , exits   // lazy exits
+          , checks  // lazy exits verified
+          , wrongs; // lazy exits verified wrong
+
+        LazyStats () { clear (); }
+
+        void clear () { evals = exits = checks = wrongs = 0; }
+    };
+
+    // Terms of the evaluation breakdown, after the pieces indexed by PieceT (PAWN...KING)
+    enum TermT : u08
+    {
+        PST = 6, IMBALANCE, MOBILITY, THREAT, PASSED, SPACE, TOTAL, TERM_NO
+    };
+
+    // Evaluation breakdown, the white and black scores of each term as in trace()
+    struct EvalTerms
+    {
+        Score terms[CLR_NO][TERM_NO];
+    };
+
     extern void initialize ();
 
-    extern Value evaluate (const Position &pos);
+    // evaluate() with the window of the caller. Material, piece-square and pawn
+    // structure are computed first, if they are already more than the lazy margin
+    // outside of [alpha, beta] that estimate is returned without the expensive terms.
+    // The default (infinite) window always gives the full evaluation.
+    // If 'lazy' is given it is set whether the value is a lazy estimate,
+    // which only bounds the evaluation and must not be stored.
+    extern Value evaluate (const Position &pos, Value alpha = -VALUE_INFINITE, Value beta = +VALUE_INFINITE, bool *lazy = NULL);
 
     extern std::string trace (const Position &pos);
 
+    // evaluate_batch() evaluates 'count' packed positions spread over the threads
+    // of the pool (which must not be searching), 'values' gets the evaluations
+    // from the side to move point of view and 'terms' (if not NULL) the breakdowns.
+    // Positions which are not valid or in check get VALUE_NONE.
+    // The values are those of evaluate() with or without terms, so while the network
+    // is active they are the network evaluations and the terms are all zero.
+    // Returns the number of positions evaluated.
+    extern u64 evaluate_batch (const PackedPosition *positions, u64 count, Value *values, EvalTerms *terms = NULL, bool c960 = false);
+
 }
 
 #endif // _EVALUATOR_H_INC_
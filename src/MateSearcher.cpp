@@ -0,0 +1,373 @@
+#include "MateSearcher.h"
+
+#include <algorithm>
+
+#include "Position.h"
+#include "MoveGenerator.h"
+#include "Searcher.h"
+
+namespace MateSearcher {
+
+    using namespace std;
+    using namespace MoveGenerator;
+    using namespace Searcher;
+
+    StatsT Stats;
+
+    namespace {
+
+        // Proof and disproof numbers saturate at INF,
+        // (phi, delta) = (0, INF) means the side to move wins, (INF, 0) means it does not.
+        const u32 INF = 100000000;
+
+        // Proof-number entry, 16 bytes. Keyed by (position key, plies left)
+        // because the same position is a different problem with a different mate horizon.
+        struct ProofEntry
+        {
+            u32 key32;
+            u32 phi;        // proof number for the side to move
+            u32 delta;      // disproof number for the side to move
+            u16 work;       // nodes spent in the subtree (saturated), used for replacement
+            u08 plies;      // plies left, 0 means empty entry
+            u08 pad;
+        };
+
+        const u08 BUCKET_SIZE = 4;
+
+        vector<ProofEntry> Table;
+        u32 TableSizeMB = 16;
+        u64 TableMask   = 0;
+
+        inline u64 table_index (Key key, u08 plies)
+        {
+            return ((key ^ (U64 (0x9E3779B97F4A7C15) * plies)) & TableMask) * BUCKET_SIZE;
+        }
+
+        inline const ProofEntry* probe (Key key, u08 plies)
+        {
+            ++Stats.probes;
+            u32 key32 = u32 (key >> 32);
+            const ProofEntry *pe = &Table[table_index (key, plies)];
+            for (u08 i = 0; i < BUCKET_SIZE; ++i, ++pe)
+            {
+                if (pe->plies == plies && pe->key32 == key32)
+                {
+                    ++Stats.hits;
+                    return pe;
+                }
+            }
+            return NULL;
+        }
+
+        inline void store (Key key, u08 plies, u32 phi, u32 delta, u64 work)
+        {
+            u32 key32 = u32 (key >> 32);
+            ProofEntry *pe = &Table[table_index (key, plies)];
+            ProofEntry *re = pe;
+            for (u08 i = 0; i < BUCKET_SIZE; ++i, ++pe)
+            {
+                if (pe->plies == plies && pe->key32 == key32)
+                {
+                    re = pe;
+                    break;
+                }
+                // Replace empty or the cheapest to recompute
+                if (pe->plies == 0 || pe->work < re->work)
+                {
+                    re = pe;
+                }
+            }
+
+            if (re->plies == 0) ++Stats.used;
+            re->key32 = key32;
+            re->phi   = phi;
+            re->delta = delta;
+            re->work  = u16 (min<u64> (work, 0xFFFF));
+            re->plies = plies;
+        }
+
+        // Children of a node, values from the child (side to move) point of view
+        struct Child
+        {
+            Move move;
+            u32  phi;
+            u32  delta;
+        };
+
+        const vector<Move> *RootMoves = NULL;
+
+        // mates() checks whether the side to move at an attacker node
+        // with one ply left has a move that mates immediately.
+        Move mates (Position &pos)
+        {
+            StateInfo si;
+            CheckInfo ci (pos);
+            for (MoveList<LEGAL> itr (pos); *itr != MOVE_NONE; ++itr)
+            {
+                Move m = *itr;
+                if (!pos.gives_check (m, ci)) continue;
+
+                ++Stats.nodes;
+                pos.do_move (m, si, &ci);
+                bool mate = (MoveList<LEGAL> (pos).size () == 0);
+                pos.undo_move ();
+
+                if (mate) return m;
+            }
+            return MOVE_NONE;
+        }
+
+        // mid() is the multiple iterative deepening step of df-pn, it expands
+        // the node until its (phi, delta) reach the given thresholds.
+        // Attacker nodes have odd plies left, defender nodes even.
+        void mid (Position &pos, u08 plies, u32 th_phi, u32 th_delta, u32 &phi, u32 &delta, bool root)
+        {
+            bool or_node = (plies & 1);
+            Key  key     = pos.posi_key ();
+            u64  nodes   = Stats.nodes;
+
+            // A draw is a failure for the attacker
+            if (!root && pos.draw ())
+            {
+                phi   = or_node ? INF : 0;
+                delta = or_node ? 0 : INF;
+                return;
+            }
+
+            if (plies == 1)
+            {
+                bool mate = (MOVE_NONE != mates (pos));
+                phi   = mate ? 0 : INF;
+                delta = mate ? INF : 0;
+                store (key, plies, phi, delta, Stats.nodes - nodes);
+                return;
+            }
+
+            Child children[MAX_MOVES];
+            u08   count  = 0
+                , checks = 0;
+
+            CheckInfo ci (pos);
+            for (MoveList<LEGAL> itr (pos); *itr != MOVE_NONE; ++itr)
+            {
+                Move m = *itr;
+                if (root && find (RootMoves->begin (), RootMoves->end (), m) == RootMoves->end ()) continue;
+
+                Child &c = children[count];
+                c.move  = m;
+                c.phi   = 1;
+                c.delta = 1;
+                // Try checks first at attacker nodes (ties go to the first child)
+                if (or_node && pos.gives_check (m, ci))
+                {
+                    swap (children[checks++], c);
+                }
+                ++count;
+            }
+
+            if (count == 0)
+            {
+                // Checkmate or stalemate, both are a failure for the side to move
+                // except stalemate of the defender which is a failure of the attacker.
+                bool win = (!or_node && pos.checkers () == U64 (0));
+                phi   = win ? 0 : INF;
+                delta = win ? INF : 0;
+                store (key, plies, phi, delta, 0);
+                return;
+            }
+
+            StateInfo si;
+            // Seed the children from the proof table (transpositions)
+            for (u08 i = 0; i < count; ++i)
+            {
+                pos.do_move (children[i].move, si);
+                const ProofEntry *pe = probe (pos.posi_key (), plies - 1);
+                if (pe != NULL)
+                {
+                    children[i].phi   = pe->phi;
+                    children[i].delta = pe->delta;
+                }
+                pos.undo_move ();
+            }
+
+            while (true)
+            {
+                // phi = min of children delta, delta = sum of children phi
+                u08 best  = 0;
+                u32 delta2 = INF;
+                phi   = INF;
+                delta = 0;
+                for (u08 i = 0; i < count; ++i)
+                {
+                    if (children[i].delta < phi)
+                    {
+                        delta2 = phi;
+                        phi    = children[i].delta;
+                        best   = i;
+                    }
+                    else if (children[i].delta < delta2)
+                    {
+                        delta2 = children[i].delta;
+                    }
+                    delta = min (delta + children[i].phi, INF);
+                }
+
+                if (phi >= th_phi || delta >= th_delta || Signals.stop) break;
+
+                Child &c = children[best];
+                u32 c_th_phi   = th_delta - (delta - c.phi);
+                u32 c_th_delta = min (th_phi, delta2 + 1);
+
+                ++Stats.nodes;
+                pos.do_move (c.move, si, &ci);
+                mid (pos, plies - 1, c_th_phi, c_th_delta, c.phi, c.delta, false);
+                pos.undo_move ();
+            }
+
+            if (!Signals.stop)
+            {
+                store (key, plies, phi, delta, Stats.nodes - nodes);
+            }
+        }
+
+        // value() gets (phi, delta) of the position from the table,
+        // or solves it again if 'resolve' and it has been evicted.
+        bool value (Position &pos, u08 plies, bool resolve, u32 &phi, u32 &delta)
+        {
+            const ProofEntry *pe = probe (pos.posi_key (), plies);
+            if (pe != NULL)
+            {
+                phi   = pe->phi;
+                delta = pe->delta;
+                return true;
+            }
+            if (resolve)
+            {
+                mid (pos, plies, INF, INF, phi, delta, false);
+                return true;
+            }
+            return false;
+        }
+
+        // extract_pv() follows the proof from the table: the attacker plays a move
+        // to a lost defender node, the defender plays a reply which is not mated sooner.
+        void extract_pv (Position &pos, u08 plies, vector<Move> &pv)
+        {
+            Move move = MOVE_NONE;
+            if (plies == 1)
+            {
+                move = mates (pos);
+            }
+            else
+            {
+                bool or_node = (plies & 1);
+                StateInfo si;
+                // First from the table only, then solving again the evicted children
+                for (u08 pass = 0; pass < 2 && move == MOVE_NONE; ++pass)
+                {
+                    for (MoveList<LEGAL> itr (pos); *itr != MOVE_NONE; ++itr)
+                    {
+                        Move m = *itr;
+                        if (pv.empty () && find (RootMoves->begin (), RootMoves->end (), m) == RootMoves->end ()) continue;
+
+                        u32 phi, delta;
+                        pos.do_move (m, si);
+                        bool found = value (pos, plies - 1, pass == 1, phi, delta);
+                        if (found && !or_node && phi == 0 && plies > 3)
+                        {
+                            // Mated sooner is not the longest defence
+                            u32 s_phi, s_delta;
+                            value (pos, plies - 3, true, s_phi, s_delta);
+                            if (s_phi != 0)
+                            {
+                                pos.undo_move ();
+                                move = m;
+                                break;
+                            }
+                        }
+                        pos.undo_move ();
+
+                        if (!found) continue;
+
+                        if (or_node ? (delta == 0) : (phi == 0))
+                        {
+                            if (or_node || plies <= 3)
+                            {
+                                move = m;
+                                break;
+                            }
+                            if (move == MOVE_NONE) move = m;
+                        }
+                    }
+                }
+            }
+
+            if (move == MOVE_NONE) return;
+
+            pv.push_back (move);
+            StateInfo si;
+            pos.do_move (move, si);
+            if (plies > 1 && MoveList<LEGAL> (pos).size () != 0)
+            {
+                extract_pv (pos, plies - 1, pv);
+            }
+            pos.undo_move ();
+        }
+
+    }
+
+    u08 solve (Position &pos, u08 mate, const vector<Move> &root_moves, vector<Move> &pv)
+    {
+        mate = min<u08> (mate, MAX_PLY / 2);
+
+        if (Table.empty ())
+        {
+            u64 entries = (u64 (TableSizeMB) << 20) / sizeof (ProofEntry);
+            // Round down to a power of 2 buckets
+            u64 buckets = 1;
+            while (buckets * 2 * BUCKET_SIZE <= entries) buckets *= 2;
+            Table.resize (buckets * BUCKET_SIZE);
+            TableMask = buckets - 1;
+        }
+        clear ();
+
+        RootMoves = &root_moves;
+        pv.clear ();
+
+        u08 m;
+        for (m = 1; m <= mate && !Signals.stop; ++m)
+        {
+            u08 plies = 2 * m - 1;
+            u32 phi, delta;
+            mid (pos, plies, INF, INF, phi, delta, true);
+
+            if (!Signals.stop && phi == 0)
+            {
+                extract_pv (pos, plies, pv);
+                return pv.empty () ? 0 : m;
+            }
+        }
+        return 0;
+    }
+
+    void resize (u32 mem_size_mb)
+    {
+        TableSizeMB = mem_size_mb;
+        vector<ProofEntry> ().swap (Table); // Allocate lazily on the next solve
+        TableMask = 0;
+    }
+
+    void clear ()
+    {
+        if (!Table.empty ())
+        {
+            fill (Table.begin (), Table.end (), ProofEntry ());
+        }
+        Stats.nodes   = 0;
+        Stats.probes  = 0;
+        Stats.hits    = 0;
+        Stats.used    = 0;
+        Stats.entries = u32 (Table.size ());
+    }
+
+}
@@ -0,0 +1,46 @@
+#ifdef _MSC_VER
+#   pragma once
+#endif
+
+#ifndef _MATE_SEARCHER_H_INC_
+#define _MATE_SEARCHER_H_INC_
+
+#include <vector>
+
+#include "Type.h"
+
+class Position;
+
+// MateSearcher is a dedicated mate solver used for "go mate <x>".
+// It runs a depth-first proof-number (df-pn) search over an AND/OR tree,
+// attacker moves are OR nodes and defender replies are AND nodes.
+// Proof and disproof numbers are kept in a separate proof table
+// so the main transposition table is not disturbed.
+namespace MateSearcher {
+
+    // Statistics of the last solve() call
+    struct StatsT
+    {
+        u64 nodes;      // nodes visited (do_move calls)
+        u64 probes;     // proof table probes
+        u64 hits;       // proof table hits
+        u32 used;       // proof table entries in use
+        u32 entries;    // proof table capacity
+    };
+
+    extern StatsT Stats;
+
+    // solve() looks for a forced mate in at most 'mate' moves for the side to move,
+    // considering only 'root_moves' at the root. Iterates mate length 1, 2, ..., 'mate'
+    // so the shortest mate is found first. Returns the mate length in moves and
+    // fills 'pv' with the mating line, or 0 if no mate is proven (or search stopped).
+    extern u08 solve (Position &pos, u08 mate, const std::vector<Move> &root_moves, std::vector<Move> &pv);
+
+    // resize() sets the proof table size in MB, called on "Mate Hash" option change.
+    extern void resize (u32 mem_size_mb);
+
+    extern void clear ();
+
+}
+
+#endif // _MATE_SEARCHER_H_INC_
@@ -4,12 +4,14 @@
 #include <cstring>
 
 #include "Position.h"
+#include "Thread.h"
 
 namespace Material {
 
     using namespace std;
     using namespace BitBoard;
     using namespace EndGame;
+    using namespace Threads;
 
     namespace {
 
@@ -54,36 +56,37 @@ namespace Material {
         Endgame<KPsK>   ScaleKPsK   [CLR_NO] = { Endgame<KPsK>   (WHITE), Endgame<KPsK>   (BLACK) };
         Endgame<KPKP>   ScaleKPKP   [CLR_NO] = { Endgame<KPKP>   (WHITE), Endgame<KPKP>   (BLACK) };
 
-        // Helper templates used to detect a given material distribution
+        // Helper templates used to detect a given material distribution,
+        // from the piece counts and the non-pawn material of both colors.
         template<Color C>
-        inline bool is_KXK(const Position &pos)
+        inline bool is_KXK    (const i32 count[CLR_NO][NONE], const Value npm[CLR_NO])
         {
             const Color C_ = ((WHITE == C) ? BLACK : WHITE);
 
-            return pos.non_pawn_material (C ) >= VALUE_MG_ROOK
-                && pos.non_pawn_material (C_) == VALUE_ZERO
-                && pos.count<PAWN> (C_) == 0;
+            return npm[C ] >= VALUE_MG_ROOK
+                && npm[C_] == VALUE_ZERO
+                && count[C_][PAWN] == 0;
         }
 
         template<Color C> 
-        inline bool is_KBPsKs(const Position &pos)
+        inline bool is_KBPsKs (const i32 count[CLR_NO][NONE], const Value npm[CLR_NO])
         {
-            return pos.non_pawn_material (C ) == VALUE_MG_BSHP
-                && pos.count<BSHP> (C ) == 1
-                && pos.count<PAWN> (C ) >= 1;
+            return npm[C] == VALUE_MG_BSHP
+                && count[C][BSHP] == 1
+                && count[C][PAWN] >= 1;
         }
 
         template<Color C>
-        inline bool is_KQKRPs(const Position &pos)
+        inline bool is_KQKRPs (const i32 count[CLR_NO][NONE], const Value npm[CLR_NO])
         {
             const Color C_  = ((WHITE == C) ? BLACK : WHITE);
 
-            return pos.non_pawn_material (C ) == VALUE_MG_QUEN
-                //&& pos.non_pawn_material (C_) == VALUE_MG_ROOK
-                && pos.count<QUEN> (C ) == 1
-                && pos.count<PAWN> (C ) == 0
-                && pos.count<ROOK> (C_) == 1
-                && pos.count<PAWN> (C_) >= 1;
+            return npm[C] == VALUE_MG_QUEN
+                //&& npm[C_] == VALUE_MG_ROOK
+                && count[C ][QUEN] == 1
+                && count[C ][PAWN] == 0
+                && count[C_][ROOK] == 1
+                && count[C_][PAWN] >= 1;
         }
 
         template<Color C>
@@ -123,155 +126,256 @@ namespace Material {
 
     } // namespace
 
-    // Material::probe () takes a position object as input,
-    // looks up a MaterialEntry object, and returns a pointer to it.
-    // If the material configuration is not already present in the table,
-    // it is computed and stored there, so we don't have to recompute everything
-    // when the same material configuration occurs again.
-    Entry* probe     (const Position &pos, Table &table, Endgames &endgames)
-    {
-        Key key  = pos.matl_key ();
-        Entry *e = table[key];
-
-        // If e->_key matches the position's material hash key, it means that we
-        // have analysed this material configuration before, and we can simply
-        // return the information we found the last time instead of recomputing it.
-        if (e->_key == key) return e;
-
-        memset (e, 0, sizeof (Entry));
-        e->_key           = key;
-        e->_factor[WHITE] = e->_factor[BLACK] = SCALE_FACTOR_NORMAL;
-        e->_game_phase    = game_phase (pos);
-
-        // Let's look if we have a specialized evaluation function for this
-        // particular material configuration. First we look for a fixed
-        // configuration one, then a generic one if previous search failed.
-        if (endgames.probe (key, e->evaluation_func))
-        {
-            return e;
-        }
+    namespace {
 
-        if (is_KXK<WHITE> (pos))
-        {
-            e->evaluation_func = &EvaluateKXK[WHITE];
-            return e;
-        }
-        if (is_KXK<BLACK> (pos))
+        inline Phase game_phase (Value npm)
         {
-            e->evaluation_func = &EvaluateKXK[BLACK];
-            return e;
+            return npm >= MidgameLimit ? PHASE_MIDGAME
+                :  npm <= EndgameLimit ? PHASE_ENDGAME
+                :  Phase (((npm - EndgameLimit) * 128) / (MidgameLimit - EndgameLimit));
         }
 
-        // OK, we didn't find any special evaluation function for the current
-        // material configuration. Is there a suitable scaling function?
-        //
-        // We face problems when there are several conflicting applicable
-        // scaling functions and we need to decide which one to use.
-        EndgameBase<ScaleFactor> *eg_sf;
-        if (endgames.probe (key, eg_sf))
+        // compute() fills the entry of a material configuration from its piece counts,
+        // KING is the place holder for the bishop pair.
+        void compute (Entry *e, Key key, const i32 count[CLR_NO][NONE])
         {
-            e->scaling_func[eg_sf->color ()] = eg_sf;
-            return e;
-        }
+            memset (e, 0, sizeof (Entry));
+            e->_key           = key;
+            e->_factor[WHITE] = e->_factor[BLACK] = SCALE_FACTOR_NORMAL;
 
-        // Generic scaling functions that refer to more than one material distribution.
-        // Should be probed after the specialized ones.
-        // Note that these ones don't return after setting the function.
+            const Value npm[CLR_NO] =
+            {
+                Value (count[WHITE][NIHT] * VALUE_MG_NIHT + count[WHITE][BSHP] * VALUE_MG_BSHP
+                     + count[WHITE][ROOK] * VALUE_MG_ROOK + count[WHITE][QUEN] * VALUE_MG_QUEN),
+                Value (count[BLACK][NIHT] * VALUE_MG_NIHT + count[BLACK][BSHP] * VALUE_MG_BSHP
+                     + count[BLACK][ROOK] * VALUE_MG_ROOK + count[BLACK][QUEN] * VALUE_MG_QUEN),
+            };
+
+            e->_game_phase    = game_phase (npm[WHITE] + npm[BLACK]);
+
+            // Let's look if we have a specialized evaluation function for this
+            // particular material configuration. First we look for a fixed
+            // configuration one, then a generic one if previous search failed.
+            if (EndgameTable->probe (key, e->evaluation_func))
+            {
+                return;
+            }
 
-        if (is_KBPsKs<WHITE> (pos))
-        {
-            e->scaling_func[WHITE] = &ScaleKBPsKs[WHITE];
-        }
-        if (is_KBPsKs<BLACK> (pos))
-        {
-            e->scaling_func[BLACK] = &ScaleKBPsKs[BLACK];
-        }
+            if (is_KXK<WHITE> (count, npm))
+            {
+                e->evaluation_func = &EvaluateKXK[WHITE];
+                return;
+            }
+            if (is_KXK<BLACK> (count, npm))
+            {
+                e->evaluation_func = &EvaluateKXK[BLACK];
+                return;
+            }
 
-        if      (is_KQKRPs<WHITE> (pos))
-        {
-            e->scaling_func[WHITE] = &ScaleKQKRPs[WHITE];
-        }
-        else if (is_KQKRPs<BLACK> (pos))
-        {
-            e->scaling_func[BLACK] = &ScaleKQKRPs[BLACK];
-        }
+            // OK, we didn't find any special evaluation function for the current
+            // material configuration. Is there a suitable scaling function?
+            //
+            // We face problems when there are several conflicting applicable
+            // scaling functions and we need to decide which one to use.
+            EndgameBase<ScaleFactor> *eg_sf;
+            if (EndgameTable->probe (key, eg_sf))
+            {
+                e->scaling_func[eg_sf->color ()] = eg_sf;
+                return;
+            }
 
+            // Generic scaling functions that refer to more than one material distribution.
+            // Should be probed after the specialized ones.
+            // Note that these ones don't return after setting the function.
 
-        Value npm[CLR_NO] = 
-        {
-            pos.non_pawn_material (WHITE),
-            pos.non_pawn_material (BLACK),
-        };
+            if (is_KBPsKs<WHITE> (count, npm))
+            {
+                e->scaling_func[WHITE] = &ScaleKBPsKs[WHITE];
+            }
+            if (is_KBPsKs<BLACK> (count, npm))
+            {
+                e->scaling_func[BLACK] = &ScaleKBPsKs[BLACK];
+            }
 
-        if (npm[WHITE] + npm[BLACK] == VALUE_ZERO && pos.pieces<PAWN> ())
-        {
-            if      (pos.count<PAWN> (BLACK) == 0
-                &&   pos.count<PAWN> (WHITE) >= 2)
+            if      (is_KQKRPs<WHITE> (count, npm))
             {
-                //ASSERT (pos.count<PAWN> (WHITE) >= 2);
-                e->scaling_func[WHITE] = &ScaleKPsK[WHITE];
+                e->scaling_func[WHITE] = &ScaleKQKRPs[WHITE];
             }
-            else if (pos.count<PAWN> (WHITE) == 0
-                &&   pos.count<PAWN> (BLACK) >= 2)
+            else if (is_KQKRPs<BLACK> (count, npm))
             {
-                //ASSERT (pos.count<PAWN> (BLACK) >= 2);
-                e->scaling_func[BLACK] = &ScaleKPsK[BLACK];
+                e->scaling_func[BLACK] = &ScaleKQKRPs[BLACK];
             }
-            else if (pos.count<PAWN> (WHITE) == 1
-                &&   pos.count<PAWN> (BLACK) == 1)
+
+            if (npm[WHITE] + npm[BLACK] == VALUE_ZERO && (count[WHITE][PAWN] + count[BLACK][PAWN]) != 0)
             {
-                // This is a special case because we set scaling functions for both colors instead of only one.
-                e->scaling_func[WHITE] = &ScaleKPKP[WHITE];
-                e->scaling_func[BLACK] = &ScaleKPKP[BLACK];
+                if      (count[BLACK][PAWN] == 0
+                    &&   count[WHITE][PAWN] >= 2)
+                {
+                    e->scaling_func[WHITE] = &ScaleKPsK[WHITE];
+                }
+                else if (count[WHITE][PAWN] == 0
+                    &&   count[BLACK][PAWN] >= 2)
+                {
+                    e->scaling_func[BLACK] = &ScaleKPsK[BLACK];
+                }
+                else if (count[WHITE][PAWN] == 1
+                    &&   count[BLACK][PAWN] == 1)
+                {
+                    // This is a special case because we set scaling functions for both colors instead of only one.
+                    e->scaling_func[WHITE] = &ScaleKPKP[WHITE];
+                    e->scaling_func[BLACK] = &ScaleKPKP[BLACK];
+                }
             }
-        }
 
-        // No pawns makes it difficult to win, even with a material advantage.
-        // This catches some trivial draws like KK, KBK and KNK and gives a very drawish
-        // scale factor for cases such as KRKBP and KmmKm (except for KBBKN).
+            // No pawns makes it difficult to win, even with a material advantage.
+            // This catches some trivial draws like KK, KBK and KNK and gives a very drawish
+            // scale factor for cases such as KRKBP and KmmKm (except for KBBKN).
 
-        if (npm[WHITE] - npm[BLACK] <= VALUE_MG_BSHP)
-        {
-            if      (pos.count<PAWN> (WHITE) == 0)
+            if (npm[WHITE] - npm[BLACK] <= VALUE_MG_BSHP)
             {
-                e->_factor[WHITE] = u08 (npm[WHITE] <= VALUE_MG_BSHP ?
-                    SCALE_FACTOR_DRAW : !pos.count<NIHT> (WHITE) && !pos.bishops_pair (WHITE) ?
-                    1 : npm[BLACK] <= VALUE_MG_BSHP ? 
-                    4 : 12);
+                if      (count[WHITE][PAWN] == 0)
+                {
+                    e->_factor[WHITE] = u08 (npm[WHITE] <= VALUE_MG_BSHP ?
+                        SCALE_FACTOR_DRAW : !count[WHITE][NIHT] && !count[WHITE][KING] ?
+                        1 : npm[BLACK] <= VALUE_MG_BSHP ? 
+                        4 : 12);
+                }
+                else if (count[WHITE][PAWN] == 1)
+                {
+                    e->_factor[WHITE] = u08 ((npm[WHITE] == npm[BLACK] || npm[WHITE] <= VALUE_MG_BSHP) ?
+                        4 : SCALE_FACTOR_ONEPAWN / (count[BLACK][PAWN] + 1));
+                }
             }
-            else if (pos.count<PAWN> (WHITE) == 1)
+
+            if (npm[BLACK] - npm[WHITE] <= VALUE_MG_BSHP)
             {
-                e->_factor[WHITE] = u08 ((npm[WHITE] == npm[BLACK] || npm[WHITE] <= VALUE_MG_BSHP) ?
-                    4 : SCALE_FACTOR_ONEPAWN / (pos.count<PAWN> (BLACK) + 1));
+                if      (count[BLACK][PAWN] == 0)
+                {
+                    e->_factor[BLACK] = u08 (npm[BLACK] <= VALUE_MG_BSHP ?
+                        SCALE_FACTOR_DRAW : !count[BLACK][NIHT] && !count[BLACK][KING] ?
+                        1 : npm[WHITE] <= VALUE_MG_BSHP ? 
+                        4 : 12);
+                }
+                else if (count[BLACK][PAWN] == 1)
+                {
+                    e->_factor[BLACK] = u08 ((npm[BLACK] == npm[WHITE] || npm[BLACK] <= VALUE_MG_BSHP) ?
+                        4 : SCALE_FACTOR_ONEPAWN / (count[WHITE][PAWN] + 1));
+                }
             }
-        }
 
-        if (npm[BLACK] - npm[WHITE] <= VALUE_MG_BSHP)
-        {
-            if      (pos.count<PAWN> (BLACK) == 0)
+            // Compute the space weight
+            if (npm[WHITE] + npm[BLACK] >= 2 * VALUE_MG_QUEN + 4 * VALUE_MG_ROOK + 2 * VALUE_MG_NIHT)
             {
-                e->_factor[BLACK] = u08 (npm[BLACK] <= VALUE_MG_BSHP ?
-                    SCALE_FACTOR_DRAW : !pos.count<NIHT> (BLACK) && !pos.bishops_pair (BLACK) ?
-                    1 : npm[WHITE] <= VALUE_MG_BSHP ? 
-                    4 : 12);
+                i32 minor_piece_count = count[WHITE][NIHT] + count[WHITE][BSHP]
+                                      + count[BLACK][NIHT] + count[BLACK][BSHP];
+                e->_space_weight = mk_score (minor_piece_count * minor_piece_count, 0);
             }
-            else if (pos.count<PAWN> (BLACK) == 1)
+
+            // Evaluate the material imbalance.
+            // We use KING as a place holder for the bishop pair "extended piece",
+            // this allow us to be more flexible in defining bishop pair bonuses.
+            e->_value = i16 ((imbalance<WHITE> (count) - imbalance<BLACK> (count)) / 16);
+        }
+
+        // Shared table of the configurations with at most the initial pieces of each kind,
+        // indexed by the signature of both colors (white * SIGNATURES + black).
+        // The signature of a color is the mixed radix number of its counts:
+        //  pawns [0, 8], knights [0, 2], bishops (0, 1, 2 same colored, 2 pair), rooks [0, 2], queens [0, 1].
+        // The bishops pair is part of the signature so the imbalance is exact.
+        const u32 SIGNATURES = 9 * 3 * 4 * 3 * 2;
+
+        vector<Entry> SharedTable;
+
+        template<Color C>
+        // signature<> () returns the signature of the color, SIGNATURES if any count is out of the bounds
+        inline u32 signature (const Position &pos)
+        {
+            i32 n = pos.count<NIHT> (C)
+              , b = pos.count<BSHP> (C)
+              , r = pos.count<ROOK> (C)
+              , q = pos.count<QUEN> (C);
+
+            if (n > 2 || b > 2 || r > 2 || q > 1) return SIGNATURES;
+
+            return (((pos.count<PAWN> (C) * 3 + n) * 4 + (b < 2 ? b : 2 + pos.bishops_pair (C))) * 3 + r) * 2 + q;
+        }
+
+        // counts() decodes the signature of the color into its piece counts
+        inline void counts (u32 sig, i32 count[NONE])
+        {
+            count[QUEN] = sig % 2; sig /= 2;
+            count[ROOK] = sig % 3; sig /= 3;
+            u32 b       = sig % 4; sig /= 4;
+            count[BSHP] = b < 2 ? b : 2;
+            count[KING] = b == 3;
+            count[NIHT] = sig % 3; sig /= 3;
+            count[PAWN] = sig;
+        }
+
+        // Rows of the shared table built by a thread
+        struct BuildWork
+        {
+            u32 begin
+              , end;
+
+            NativeHandle handle;
+        };
+
+        // build_routine() is the C function which is called on a new native thread
+        // to build the rows of the shared table of some white signatures.
+        extern "C" { long build_routine (BuildWork *bw)
+        {
+            i32 count[CLR_NO][NONE];
+            for (u32 w = bw->begin; w < bw->end; ++w)
             {
-                e->_factor[BLACK] = u08 ((npm[BLACK] == npm[WHITE] || npm[BLACK] <= VALUE_MG_BSHP) ?
-                    4 : SCALE_FACTOR_ONEPAWN / (pos.count<PAWN> (WHITE) + 1));
+                counts (w, count[WHITE]);
+                for (u32 b = 0; b < SIGNATURES; ++b)
+                {
+                    counts (b, count[BLACK]);
+
+                    Key key = U64 (0);
+                    for (Color c = WHITE; c <= BLACK; ++c)
+                    {
+                        for (PieceT pt = PAWN; pt <= QUEN; ++pt)
+                        {
+                            for (i32 pc = 0; pc < count[c][pt]; ++pc)
+                            {
+                                key ^= Zob._.piecesq[c][pt][pc];
+                            }
+                        }
+                        key ^= Zob._.piecesq[c][KING][0];
+                    }
+
+                    compute (&SharedTable[w * SIGNATURES + b], key, count);
+                }
             }
-        }
+            return 0;
+        } }
 
-        // Compute the space weight
-        if (npm[WHITE] + npm[BLACK] >= 2 * VALUE_MG_QUEN + 4 * VALUE_MG_ROOK + 2 * VALUE_MG_NIHT)
+    }
+
+    // Material::probe () takes a position object as input,
+    // looks up a MaterialEntry object, and returns a pointer to it.
+    // The configurations without promoted pieces are read from the shared table.
+    // Any other is computed and stored in the hash table of the thread,
+    // so we don't have to recompute everything when it occurs again.
+    Entry* probe     (const Position &pos, Table &table)
+    {
+        u32 w = signature<WHITE> (pos);
+        u32 b = signature<BLACK> (pos);
+        if (w != SIGNATURES && b != SIGNATURES)
         {
-            i32 minor_piece_count = pos.count<NIHT> () + pos.count<BSHP> ();
-            e->_space_weight = mk_score (minor_piece_count * minor_piece_count, 0);
+            return &SharedTable[w * SIGNATURES + b];
         }
 
-        // Evaluate the material imbalance.
-        // We use KING as a place holder for the bishop pair "extended piece",
-        // this allow us to be more flexible in defining bishop pair bonuses.
+        Key key  = pos.matl_key ();
+        Entry *e = table[key];
+
+        // If e->_key matches the position's material hash key, it means that we
+        // have analysed this material configuration before, and we can simply
+        // return the information we found the last time instead of recomputing it.
+        if (e->_key == key) return e;
+
         const i32 count[CLR_NO][NONE] =
         {
             {
@@ -284,7 +388,7 @@ namespace Material {
             },
         };
 
-        e->_value = i16 ((imbalance<WHITE> (count) - imbalance<BLACK> (count)) / 16);
+        compute (e, key, count);
         return e;
     }
 
@@ -292,11 +396,40 @@ namespace Material {
     // Because the phase is strictly a function of the material, it is stored in MaterialEntry.
     Phase game_phase (const Position &pos)
     {
-        Value npm = pos.non_pawn_material (WHITE) + pos.non_pawn_material (BLACK);
+        return game_phase (pos.non_pawn_material (WHITE) + pos.non_pawn_material (BLACK));
+    }
 
-        return npm >= MidgameLimit ? PHASE_MIDGAME
-            :  npm <= EndgameLimit ? PHASE_ENDGAME
-            :  Phase (((npm - EndgameLimit) * 128) / (MidgameLimit - EndgameLimit));
+    // Material::initialize () builds the shared table, the rows are spread over the processors.
+    // The endgame table must be built before.
+    void initialize ()
+    {
+        deinitialize ();
+
+        SharedTable.resize (SIGNATURES * SIGNATURES);
+
+        u32 threads = max (1U, min (cpu_count (), u32 (MAX_THREADS)));
+        u32 slice   = (SIGNATURES + threads - 1) / threads;
+
+        vector<BuildWork> works (threads);
+        for (u32 t = 0; t < threads; ++t)
+        {
+            works[t].begin = min (t * slice, SIGNATURES);
+            works[t].end   = min (works[t].begin + slice, SIGNATURES);
+        }
+        for (u32 t = 1; t < threads; ++t)
+        {
+            thread_create (works[t].handle, build_routine, &works[t]);
+        }
+        build_routine (&works[0]);
+        for (u32 t = 1; t < threads; ++t)
+        {
+            thread_join (works[t].handle);
+        }
+    }
+
+    void deinitialize ()
+    {
+        vector<Entry> ().swap (SharedTable);
     }
 
 } // namespace Material
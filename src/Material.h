@@ -67,10 +67,16 @@ namespace Material {
 
     typedef HashTable<Entry, 8192> Table;
 
-    Entry* probe     (const Position &pos, Table &table, EndGame::Endgames &endgames);
+    Entry* probe     (const Position &pos, Table &table);
     
     Phase game_phase (const Position &pos);
 
+    // initialize() builds the read-only material table shared by all the threads,
+    // it holds every configuration without promoted pieces, so they never miss.
+    // The hash table of each thread only keeps the other configurations.
+    extern void initialize ();
+    extern void deinitialize ();
+
 }
 
 #endif // _MATERIAL_H_INC_
@@ -163,8 +163,9 @@ namespace MoveGenerator {
                 {
                     if (pos.can_castle (C) && !pos.checkers ())
                     {
+                        // Only the check generators look at the check info
                         CheckInfo cc;
-                        if (!ci)
+                        if (!ci && (CHECK == GT || QUIET_CHECK == GT))
                         {
                             cc = CheckInfo (pos);
                             ci = &cc;
@@ -257,14 +258,20 @@ namespace MoveGenerator {
             // void Generator<GT, C, PAWN>::generate()
             // Generates PAWN common move
             static INLINE void generate (ValMove *&moves, const Position &pos, Bitboard targets, const CheckInfo *ci = NULL)
+            {
+                generate (moves, pos, pos.pieces<PAWN> (C), targets, ci);
+            }
+
+            // template<GenT GT, Color C>
+            // void Generator<GT, C, PAWN>::generate()
+            // Generates PAWN common move of the given pawns only
+            static INLINE void generate (ValMove *&moves, const Position &pos, Bitboard pawns, Bitboard targets, const CheckInfo *ci)
             {
                 const Color C_   = ((WHITE == C) ? BLACK : WHITE);
                 const Delta PUSH = ((WHITE == C) ? DEL_N  : DEL_S);
                 const Delta RCAP = ((WHITE == C) ? DEL_NE : DEL_SW);
                 const Delta LCAP = ((WHITE == C) ? DEL_NW : DEL_SE);
 
-                Bitboard pawns = pos.pieces<PAWN> (C);
-
                 Bitboard RR7_bb = rel_rank_bb (C, R_7);
                 Bitboard pawns_on_R7 = pawns &  RR7_bb;
                 Bitboard pawns_on_Rx = pawns & ~RR7_bb;
@@ -351,7 +358,8 @@ namespace MoveGenerator {
                             if (EVASION != GT || (targets & (ep_sq - PUSH)))
                             {
                                 Bitboard pawns_ep = PawnAttacks[C_][ep_sq] & pawns_on_R5;
-                                ASSERT (pawns_ep != U64 (0));
+                                // Not when only some of the pawns are generated
+                                ASSERT (pawns_ep != U64 (0) || pawns != pos.pieces<PAWN> (C));
                                 ASSERT (pop_count<MAX15> (pawns_ep) <= 2);
 
                                 while (pawns_ep != U64 (0))
@@ -397,6 +405,263 @@ namespace MoveGenerator {
             return moves;
         }
 
+        template<Delta D>
+        // Fill queen promotions in the list, where the 'D' is the direction of the pawns
+        INLINE void serialize_promotions (ValMove *&moves, Bitboard promotes)
+        {
+            while (promotes != U64 (0))
+            {
+                Square dst = pop_lsq (promotes);
+                (moves++)->move = mk_move<PROMOTE> (dst - D, dst, QUEN);
+            }
+        }
+
+        template<Color C>
+        // Generates the captures and the queen promotions in MVV/LVA order, the victims
+        // visited from the most valuable through the enemy bitboards, each taken by the
+        // least valuable attacker first:
+        //  - Capture promotions (they win the most), then captures of the queens,
+        //  - Quiet promotions (a queen less a pawn), then captures of the rooks, bishops,
+        //    knights and pawns, then en-passant captures.
+        // The attacks of the pieces are computed once, only the attacked victims are visited.
+        INLINE ValMove* generate_ordered_captures (ValMove *moves, const Position &pos)
+        {
+            const Color C_   = ((WHITE == C) ? BLACK : WHITE);
+            const Delta PUSH = ((WHITE == C) ? DEL_N  : DEL_S);
+            const Delta RCAP = ((WHITE == C) ? DEL_NE : DEL_SW);
+            const Delta LCAP = ((WHITE == C) ? DEL_NW : DEL_SE);
+
+            Bitboard occ     = pos.pieces ();
+            Bitboard enemies = pos.pieces (C_);
+
+            Bitboard RR7_bb = rel_rank_bb (C, R_7);
+            Bitboard pawns  = pos.pieces<PAWN> (C);
+            Bitboard pawns_on_R7 = pawns &  RR7_bb;
+            Bitboard pawns_on_Rx = pawns & ~RR7_bb;
+
+            Bitboard l_captures = shift_del<LCAP> (pawns_on_Rx) & enemies;
+            Bitboard r_captures = shift_del<RCAP> (pawns_on_Rx) & enemies;
+
+            // Pieces with some capture, from the least valuable
+            Square   orgs   [16 + 1];
+            Bitboard attacks[16 + 1];
+            u08 n = 0;
+
+            const Square *pl;
+            Square s;
+            pl = pos.list<NIHT> (C);
+            while ((s = *pl++) != SQ_NO) { orgs[n] = s; attacks[n] = PieceAttacks[NIHT][s] & enemies; n += (attacks[n] != U64 (0)); }
+            pl = pos.list<BSHP> (C);
+            while ((s = *pl++) != SQ_NO) { orgs[n] = s; attacks[n] = attacks_bb<BSHP> (s, occ) & enemies; n += (attacks[n] != U64 (0)); }
+            pl = pos.list<ROOK> (C);
+            while ((s = *pl++) != SQ_NO) { orgs[n] = s; attacks[n] = attacks_bb<ROOK> (s, occ) & enemies; n += (attacks[n] != U64 (0)); }
+            pl = pos.list<QUEN> (C);
+            while ((s = *pl++) != SQ_NO) { orgs[n] = s; attacks[n] = attacks_bb<QUEN> (s, occ) & enemies; n += (attacks[n] != U64 (0)); }
+            s = pos.king_sq (C);
+            orgs[n] = s; attacks[n] = PieceAttacks[KING][s] & ~PieceAttacks[KING][pos.king_sq (C_)] & enemies; n += (attacks[n] != U64 (0));
+
+            // Victims attacked by some piece, only these are visited
+            Bitboard attacked = l_captures | r_captures;
+            for (u08 i = 0; i < n; ++i)
+            {
+                attacked |= attacks[i];
+            }
+
+            if (pawns_on_R7 != U64 (0))
+            {
+                Bitboard l_promotes = shift_del<LCAP> (pawns_on_R7) & enemies;
+                Bitboard r_promotes = shift_del<RCAP> (pawns_on_R7) & enemies;
+                if ((l_promotes | r_promotes) != U64 (0))
+                {
+                    for (PieceT pt = QUEN; pt >= NIHT; --pt)
+                    {
+                        Bitboard victims = pos.pieces (C_, pt);
+                        serialize_promotions<LCAP> (moves, l_promotes & victims);
+                        serialize_promotions<RCAP> (moves, r_promotes & victims);
+                    }
+                }
+            }
+
+            for (PieceT pt = QUEN; pt >= PAWN; --pt)
+            {
+                Bitboard victims = pos.pieces (C_, pt) & attacked;
+                if (victims != U64 (0))
+                {
+                    Bitboard l_attacks = l_captures & victims;
+                    Bitboard r_attacks = r_captures & victims;
+
+                    SERIALIZE_PAWNS (moves, LCAP, l_attacks);
+                    SERIALIZE_PAWNS (moves, RCAP, r_attacks);
+
+                    for (u08 i = 0; i < n; ++i)
+                    {
+                        Bitboard captures = attacks[i] & victims;
+                        SERIALIZE (moves, orgs[i], captures);
+                    }
+                }
+
+                if (QUEN == pt && pawns_on_R7 != U64 (0))
+                {
+                    serialize_promotions<PUSH> (moves, shift_del<PUSH> (pawns_on_R7) & ~occ);
+                }
+            }
+
+            // En-passant captures win a pawn with a pawn, put last with the other ones
+            Square ep_sq = pos.en_passant_sq ();
+            if (SQ_NO != ep_sq)
+            {
+                ASSERT (_rank (ep_sq) == rel_rank (C, R_6));
+                Bitboard pawns_ep = PawnAttacks[C_][ep_sq] & pawns_on_Rx & rel_rank_bb (C, R_5);
+                while (pawns_ep != U64 (0))
+                {
+                    (moves++)->move = mk_move<ENPASSANT> (pop_lsq (pawns_ep), ep_sq);
+                }
+            }
+
+            return moves;
+        }
+
+        template<Color C>
+        // Squares attacked by the pieces of color on the given occupancy
+        INLINE Bitboard attacked_bb (const Position &pos, Bitboard occ)
+        {
+            const Delta RCAP = ((WHITE == C) ? DEL_NE : DEL_SW);
+            const Delta LCAP = ((WHITE == C) ? DEL_NW : DEL_SE);
+
+            Bitboard pawns = pos.pieces<PAWN> (C);
+            Bitboard attacked = shift_del<RCAP> (pawns) | shift_del<LCAP> (pawns)
+                              | PieceAttacks[KING][pos.king_sq (C)];
+
+            const Square *pl;
+            Square s;
+            pl = pos.list<NIHT> (C);
+            while ((s = *pl++) != SQ_NO) attacked |= PieceAttacks[NIHT][s];
+            pl = pos.list<BSHP> (C);
+            while ((s = *pl++) != SQ_NO) attacked |= attacks_bb<BSHP> (s, occ);
+            pl = pos.list<ROOK> (C);
+            while ((s = *pl++) != SQ_NO) attacked |= attacks_bb<ROOK> (s, occ);
+            pl = pos.list<QUEN> (C);
+            while ((s = *pl++) != SQ_NO) attacked |= attacks_bb<QUEN> (s, occ);
+
+            return attacked;
+        }
+
+        template<Color C, PieceT PT>
+        // Generates legal moves of the piece type, pinned pieces move only along their pin ray
+        INLINE void generate_legal (ValMove *&moves, const Position &pos, Bitboard targets, Bitboard pinneds, Square king_sq)
+        {
+            Bitboard occ = pos.pieces ();
+
+            const Square *pl = pos.list<PT> (C);
+            Square s;
+            while ((s = *pl++) != SQ_NO)
+            {
+                Bitboard attacks = attacks_bb<PT> (s, occ) & targets;
+                if (UNLIKELY (pinneds) && (pinneds & s)) attacks &= LineRay_bb[king_sq][s];
+
+                SERIALIZE (moves, s, attacks);
+            }
+        }
+
+        template<Color C>
+        // Generates all legal moves of color directly, without a legality filter:
+        //  - The king moves only to squares not attacked by the enemy (king removed from the occupancy),
+        //  - Under check the other pieces move only to the blocking squares or on the checker,
+        //    and under double check only the king moves,
+        //  - The pinned pieces move only along the ray through their king.
+        // Only en-passant captures, being rare and tricky, are tested with Position::legal().
+        INLINE ValMove* generate_legal (ValMove *moves, const Position &pos)
+        {
+            const Color C_ = ((WHITE == C) ? BLACK : WHITE);
+
+            Square  king_sq  = pos.king_sq (C);
+            Bitboard friends = pos.pieces (C);
+            Bitboard checkers= pos.checkers ();
+
+            Bitboard king_attacks = PieceAttacks[KING][king_sq] & ~friends;
+            if (king_attacks != U64 (0))
+            {
+                king_attacks &= ~attacked_bb<C_> (pos, pos.pieces () - king_sq);
+            }
+
+            // Same order as the pseudo-legal generators: under check the king moves first
+            if (checkers != U64 (0))
+            {
+                SERIALIZE (moves, king_sq, king_attacks);
+
+                // If double check, then only a king move can save the day
+                if (more_than_one (checkers)) return moves;
+            }
+
+            Bitboard targets = checkers != U64 (0)
+                ? Between_bb[scan_lsq (checkers)][king_sq] | checkers
+                : ~friends;
+
+            Bitboard pinneds = pos.pinneds (C);
+            Bitboard pawns   = pos.pieces<PAWN> (C);
+
+            ValMove *beg = moves;
+            // Pawns use the evasion generator, it restricts all the destinations to the targets
+            Generator<EVASION, C, PAWN>::generate (moves, pos, pawns & ~pinneds, targets, NULL);
+            // A pinned piece can never resolve a check
+            if (checkers == U64 (0))
+            {
+                Bitboard pinned_pawns = pawns & pinneds;
+                while (pinned_pawns != U64 (0))
+                {
+                    Square s = pop_lsq (pinned_pawns);
+                    Generator<EVASION, C, PAWN>::generate (moves, pos, Square_bb[s], targets & LineRay_bb[king_sq][s], NULL);
+                }
+            }
+
+            Square ep_sq = pos.en_passant_sq ();
+            if (SQ_NO != ep_sq)
+            {
+                // The evasion generator allows en-passant captures of pawns in the targets only,
+                // and a pinned pawn captures en-passant only along its pin ray
+                if (checkers == U64 (0))
+                {
+                    Bitboard pawns_ep = PawnAttacks[C_][ep_sq] & pawns & pinneds & LineRay_bb[king_sq][ep_sq];
+                    while (pawns_ep != U64 (0))
+                    {
+                        (moves++)->move = mk_move<ENPASSANT> (pop_lsq (pawns_ep), ep_sq);
+                    }
+                }
+
+                ValMove *cur = beg;
+                while (cur != moves)
+                {
+                    if (ENPASSANT == mtype (cur->move) && !pos.legal (cur->move, pinneds))
+                    {
+                        cur->move = (--moves)->move;
+                    }
+                    else
+                    {
+                        ++cur;
+                    }
+                }
+            }
+
+            generate_legal<C, NIHT> (moves, pos, targets, pinneds, king_sq);
+            generate_legal<C, BSHP> (moves, pos, targets, pinneds, king_sq);
+            generate_legal<C, ROOK> (moves, pos, targets, pinneds, king_sq);
+            generate_legal<C, QUEN> (moves, pos, targets, pinneds, king_sq);
+
+            if (checkers == U64 (0))
+            {
+                SERIALIZE (moves, king_sq, king_attacks);
+
+                // Castling moves are checked for legality by the king generator itself,
+                // the target squares of the king are empty so no normal king move is added.
+                if (pos.can_castle (C))
+                {
+                    Generator<QUIET, C, KING>::generate (moves, pos, U64 (0));
+                }
+            }
+
+            return moves;
+        }
+
         //INLINE void filter_illegal (ValMove *beg, ValMove *&end, const Position &pos)
         //{
         //    Square king_sq = pos.king_sq (pos.active ());
@@ -583,32 +848,29 @@ namespace MoveGenerator {
     }
 
     template<>
-    // Generates all legal moves.
-    ValMove* generate<LEGAL>       (ValMove *moves, const Position &pos)
+    // Generates all pseudo-legal captures and queen promotions in MVV/LVA order.
+    // Returns a pointer to the end of the move list.
+    ValMove* generate<QS_CAPTURE>  (ValMove *moves, const Position &pos)
     {
-        ValMove *end = pos.checkers ()
-            ? generate<EVASION> (moves, pos)
-            : generate<RELAX  > (moves, pos);
+        ASSERT (pos.checkers () == U64 (0));
 
-        Square   king_sq = pos.king_sq (pos.active ());
-        Bitboard pinneds = pos.pinneds (pos.active ());
+        Color active = pos.active ();
 
-        ValMove *cur = moves;
-        while (cur != end)
-        {
-            Move m = cur->move;
-            if (  ((org_sq (m) == king_sq) || pinneds  != U64 (0) || ENPASSANT == mtype (m))
-                && !pos.legal (m, pinneds))
-            {
-                cur->move = (--end)->move;
-            }
-            else
-            {
-                ++cur;
-            }
-        }
+        return WHITE == active ? generate_ordered_captures<WHITE> (moves, pos)
+            :  BLACK == active ? generate_ordered_captures<BLACK> (moves, pos)
+            :  moves;
+    }
+
+    template<>
+    // Generates all legal moves.
+    // Returns a pointer to the end of the move list.
+    ValMove* generate<LEGAL>       (ValMove *moves, const Position &pos)
+    {
+        Color active = pos.active ();
 
-        return end;
+        return WHITE == active ? generate_legal<WHITE> (moves, pos)
+            :  BLACK == active ? generate_legal<BLACK> (moves, pos)
+            :  moves;
     }
 
 #undef SERIALIZE
@@ -41,6 +41,7 @@ namespace MoveGenerator {
         QUIET,       // Do not capture pieces but under-promotion is allowed.
         CHECK,       // Checks the enemy King in any way possible.
         QUIET_CHECK, // Do not change material and only checks the enemy King (no capture or promotion).
+        QS_CAPTURE,  // Same as CAPTURE but in MVV/LVA order, for the quiescence search (MVVLVA).
 
         // ------------------------
         LEGAL        // Legal moves
@@ -7,6 +7,20 @@ using namespace std;
 using namespace Searcher;
 using namespace MoveGenerator;
 
+namespace {
+
+    // Picks of the quiet moves (the first one alone) before the rest of the stage gets sorted
+    const u08 LAZY_PICKS = 2;
+
+    // Unary predicate functor used by std::partition to split the packed moves
+    // with a positive score from the remaining ones.
+    struct PositivePacked
+    {
+        inline bool operator() (PackedMove pm) const { return (pm >= pack_move (MOVE_NONE, Value (1))); }
+    };
+
+}
+
 // Constructors of the MovePicker class. As arguments we pass information
 // to help it to return the (presumably) good moves first, to decide which
 // moves to return (in the quiescence search, for instance, we only want to
@@ -14,8 +28,8 @@ using namespace MoveGenerator;
 // move ordering is at the current node.
 
 MovePicker::MovePicker (const Position &p, const HistoryStats &h, Move ttm, Depth d, Move *cm, Move *fm, Stack *s)
-    : cur (moves)
-    , end (moves)
+    : cur (packs)
+    , end (packs)
     , pos (p)
     , history (h)
     , ss (s)
@@ -25,7 +39,7 @@ MovePicker::MovePicker (const Position &p, const HistoryStats &h, Move ttm, Dept
 {
     ASSERT (d > DEPTH_ZERO);
 
-    bad_captures_end = moves+MAX_MOVES-1;
+    bad_captures_end = packs+MAX_MOVES-1;
 
     stage = pos.checkers () ? EVASIONS : MAIN_STAGE;
 
@@ -34,8 +48,8 @@ MovePicker::MovePicker (const Position &p, const HistoryStats &h, Move ttm, Dept
 }
 
 MovePicker::MovePicker (const Position &p, const HistoryStats &h, Move ttm, Depth d, Square sq)
-    : cur (moves)
-    , end (moves)
+    : cur (packs)
+    , end (packs)
     , pos (p)
     , history (h)
     , ss (NULL)
@@ -77,8 +91,8 @@ MovePicker::MovePicker (const Position &p, const HistoryStats &h, Move ttm, Dept
 }
 
 MovePicker::MovePicker (const Position &p, const HistoryStats &h, Move ttm,          PieceT pt)
-    : cur (moves)
-    , end (moves)
+    : cur (packs)
+    , end (packs)
     , pos (p)
     , history (h)
     , ss (NULL)
@@ -102,11 +116,12 @@ MovePicker::MovePicker (const Position &p, const HistoryStats &h, Move ttm,
 }
 
 
-// value() assign a numerical move ordering score to each move in a move list.
+// value() packs the generated moves with their move ordering score, the scores
+// are looked up in tables (piece values, history rows) with no sorting on the way.
 // The moves with highest scores will be picked first.
 
 template<>
-void MovePicker::value<CAPTURE> ()
+void MovePicker::value<CAPTURE> (const ValMove *moves_end)
 {
     // Winning and equal captures in the main search are ordered by MVV/LVA.
     // Suprisingly, this appears to perform slightly better than SEE based
@@ -121,60 +136,76 @@ void MovePicker::value<CAPTURE> ()
     // bad_captures[] array, but instead of doing it now we delay till when
     // the move has been picked up in pick_move(), this way we save
     // some SEE calls in case we get a cutoff (idea from Pablo Vazquez).
-    for (ValMove *itr = moves; itr != end; ++itr)
+    PackedMove *pm = packs;
+    for (const ValMove *itr = moves; itr != moves_end; ++itr, ++pm)
     {
         Move m = itr->move;
-        itr->value = PieceValue[MG][ptype (pos[dst_sq (m)])] - ptype (pos[org_sq (m)]);
+        Value value = PieceValue[MG][ptype (pos[dst_sq (m)])] - ptype (pos[org_sq (m)]);
 
         MoveT mt = mtype (m);
         if      (PROMOTE == mt)
         {
-            itr->value += PieceValue[MG][promote (m)] - PieceValue[MG][PAWN];
+            value += PieceValue[MG][promote (m)] - PieceValue[MG][PAWN];
         }
         else if (ENPASSANT == mt)
         {
-            itr->value += PieceValue[MG][PAWN];
+            value += PieceValue[MG][PAWN];
         }
+        *pm = pack_move (m, value);
     }
 }
 
 template<>
-void MovePicker::value<QUIET>   ()
+void MovePicker::value<QUIET>   (const ValMove *moves_end)
 {
-    for (ValMove *itr = moves; itr != end; ++itr)
+    PackedMove *pm = packs;
+    for (const ValMove *itr = moves; itr != moves_end; ++itr, ++pm)
     {
         Move m = itr->move;
-        itr->value = history[pos[org_sq (m)]][dst_sq (m)];
+        *pm = pack_move (m, history[pos[org_sq (m)]][dst_sq (m)]);
     }
 }
 
 template<>
-void MovePicker::value<EVASION> ()
+void MovePicker::value<EVASION> (const ValMove *moves_end)
 {
     // Try good captures ordered by MVV/LVA, then non-captures if destination square
     // is not under attack, ordered by history value, then bad-captures and quiet
     // moves with a negative SEE. This last group is ordered by the SEE value.
-    for (ValMove *itr = moves; itr != end; ++itr)
+    PackedMove *pm = packs;
+    for (const ValMove *itr = moves; itr != moves_end; ++itr, ++pm)
     {
         Move m = itr->move;
 
+        Value value;
         Value gain_value = pos.see_sign (m);
         if      (gain_value < VALUE_ZERO)
         {
-            itr->value = gain_value - VALUE_KNOWN_WIN; // At the bottom
+            value = gain_value - VALUE_KNOWN_WIN; // At the bottom
         }
         else
         {
             if (pos.capture (m))
             {
-                itr->value = PieceValue[MG][ptype (pos[dst_sq (m)])]
+                value = PieceValue[MG][ptype (pos[dst_sq (m)])]
                 - ptype (pos[org_sq (m)]) + VALUE_KNOWN_WIN;
             }
             else
             {
-                itr->value = history[pos[org_sq (m)]][dst_sq (m)];
+                value = history[pos[org_sq (m)]][dst_sq (m)];
             }
         }
+        *pm = pack_move (m, value);
+    }
+}
+
+// pack() packs the generated moves with no score, for the moves not to be ordered.
+void MovePicker::pack (const ValMove *moves_end)
+{
+    PackedMove *pm = packs;
+    for (const ValMove *itr = moves; itr != moves_end; ++itr, ++pm)
+    {
+        *pm = PackedMove (itr->move);
     }
 }
 
@@ -182,94 +213,110 @@ void MovePicker::value<EVASION> ()
 // when there are no more moves to try for the current stage.
 void MovePicker::generate_next_stage ()
 {
-    cur = moves;
+    cur = packs;
+    lazy_picks = 0;
 
     switch (++stage)
     {
 
     case CAPTURES_S1:
+#ifndef MVVLVA
     case CAPTURES_S3:
     case CAPTURES_S4:
+#endif
     case CAPTURES_S5:
+#ifndef MVVLVA
     case CAPTURES_S6:
-        end = generate<CAPTURE> (moves, pos);
-        if (moves < end-1)
+#endif
         {
-            value<CAPTURE> ();
+            const ValMove *moves_end = generate<CAPTURE> (moves, pos);
+            end = packs + (moves_end - moves);
+            value<CAPTURE> (moves_end);
         }
         return;
 
+#ifdef MVVLVA
+    case CAPTURES_S3:
+    case CAPTURES_S4:
+    case CAPTURES_S6:
+        // Quiescence captures come out already in MVV/LVA order, they are
+        // neither scored nor packed but read right from the generated moves.
+        qs_cur = moves;
+        qs_end = generate<QS_CAPTURE> (moves, pos);
+        end = cur + (qs_cur != qs_end); // Not empty until all the moves are read
+        return;
+#endif
+
     case KILLERS_S1:
         // Killer moves usually come right after after the hash move and (good) captures
         cur = end = killers;
 
-        killers[0].move =           //killer_moves[0];
-        killers[1].move =           //killer_moves[1];
-        killers[2].move =           //counter_moves[0]
-        killers[3].move =           //counter_moves[1]
-        killers[4].move =           //followup_moves[0]
-        killers[5].move = MOVE_NONE;//followup_moves[1]
+        killers[0] =           //killer_moves[0];
+        killers[1] =           //killer_moves[1];
+        killers[2] =           //counter_moves[0]
+        killers[3] =           //counter_moves[1]
+        killers[4] =           //followup_moves[0]
+        killers[5] = MOVE_NONE;//followup_moves[1]
 
         // Be sure killer moves are not MOVE_NONE
         for (i08 i = 0; i < 2; ++i)
         {
             if (ss->killer_moves[i])
             {
-                (end++)->move = ss->killer_moves[i];
+                *(end++) = ss->killer_moves[i];
             }
         }
         //// If killer moves are same
         //if (ss->killers[1] && ss->killers[1] == ss->killers[0]) // Due to SMP races
         //{
-        //    (--end)->move = MOVE_NONE;
+        //    *(--end) = MOVE_NONE;
         //}
 
         // Be sure counter moves are not MOVE_NONE & different from killer moves
         for (i08 i = 0; i < 2; ++i)
         {
             if (counter_moves[i] &&
-                counter_moves[i] != cur[0].move &&
-                counter_moves[i] != cur[1].move)
+                counter_moves[i] != cur[0] &&
+                counter_moves[i] != cur[1])
             {
-                (end++)->move = counter_moves[i];
+                *(end++) = counter_moves[i];
             }
         }
         //// If counter moves are same
         //if (counter_moves[1] && counter_moves[1] == counter_moves[0]) // Due to SMP races
         //{
-        //    (--end)->move = MOVE_NONE;
+        //    *(--end) = MOVE_NONE;
         //}
 
         // Be sure followup moves are not MOVE_NONE & different from killer & counter moves
         for (i08 i = 0; i < 2; ++i)
         {
             if (followup_moves[i] &&
-                followup_moves[i] != cur[0].move &&
-                followup_moves[i] != cur[1].move &&
-                followup_moves[i] != cur[2].move &&
-                followup_moves[i] != cur[3].move)
+                followup_moves[i] != cur[0] &&
+                followup_moves[i] != cur[1] &&
+                followup_moves[i] != cur[2] &&
+                followup_moves[i] != cur[3])
             {
-                (end++)->move = followup_moves[i];
+                *(end++) = followup_moves[i];
             }
         }
         //// If followup moves are same
         //if (followup_moves[1] && followup_moves[1] == followup_moves[0]) // Due to SMP races
         //{
-        //    (--end)->move = MOVE_NONE;
+        //    *(--end) = MOVE_NONE;
         //}
 
         return;
 
     case QUIETS_1_S1:
-        end = quiets_end = generate<QUIET> (moves, pos);
-        if (moves < end)
         {
-            value<QUIET> ();
-            end = partition (cur, end, ValMove ());
-            if (moves < end-1)
-            {
-                insertion_sort ();
-            }
+            const ValMove *moves_end = generate<QUIET> (moves, pos);
+            end = quiets_end = packs + (moves_end - moves);
+            value<QUIET> (moves_end);
+            // Only the moves with a positive score are sorted first (the threshold is
+            // the packed zero score), and lazily: most of the cut nodes need one move.
+            end = partition (cur, end, PositivePacked ());
+            lazy_picks = LAZY_PICKS;
         }
         return;
 
@@ -284,20 +331,31 @@ void MovePicker::generate_next_stage ()
 
     case BAD_CAPTURES_S1:
         // Just pick them in reverse order to get MVV/LVA ordering
-        cur = moves+MAX_MOVES-1;
+        cur = packs+MAX_MOVES-1;
         end = bad_captures_end;
         return;
 
     case EVASIONS_S2:
-        end = generate<EVASION> (moves, pos);
-        if (moves < end-1)
         {
-            value<EVASION> ();
+            const ValMove *moves_end = generate<EVASION> (moves, pos);
+            end = packs + (moves_end - moves);
+            if (moves < moves_end-1)
+            {
+                value<EVASION> (moves_end);
+            }
+            else
+            {
+                pack (moves_end);
+            }
         }
         return;
 
     case QUIET_CHECKS_S3:
-        end = generate<QUIET_CHECK> (moves, pos);
+        {
+            const ValMove *moves_end = generate<QUIET_CHECK> (moves, pos);
+            end = packs + (moves_end - moves);
+            pack (moves_end);
+        }
         return;
 
     case EVASIONS:
@@ -346,16 +404,18 @@ Move MovePicker::next_move<false> ()
             do
             {
                 pick_best ();
-                move = (cur++)->move;
+                move = unpack_move (*cur);
                 if (move != tt_move)
                 {
                     if (pos.see_sign (move) >= VALUE_ZERO)
                     {
+                        ++cur;
                         return move;
                     }
                     // Losing capture, move it to the tail of the array
-                    (bad_captures_end--)->move = move;
+                    *(bad_captures_end--) = *cur;
                 }
+                ++cur;
             }
             while (cur < end);
             break;
@@ -363,7 +423,7 @@ Move MovePicker::next_move<false> ()
         case KILLERS_S1:
             do
             {
-                move = (cur++)->move;
+                move = unpack_move (*(cur++));
                 if (    move != MOVE_NONE
                     &&  pos.pseudo_legal (move)
                     &&  move != tt_move
@@ -379,14 +439,26 @@ Move MovePicker::next_move<false> ()
         case QUIETS_2_S1:
             do
             {
-                move = (cur++)->move;
+                if (lazy_picks != 0)
+                {
+                    // Pick the first move alone, sort the rest once they are needed
+                    if (--lazy_picks != 0)
+                    {
+                        pick_first ();
+                    }
+                    else
+                    {
+                        insertion_sort ();
+                    }
+                }
+                move = unpack_move (*(cur++));
                 if (   move != tt_move
-                    && move != killers[0].move
-                    && move != killers[1].move
-                    && move != killers[2].move
-                    && move != killers[3].move
-                    && move != killers[4].move
-                    && move != killers[5].move)
+                    && move != unpack_move (killers[0])
+                    && move != unpack_move (killers[1])
+                    && move != unpack_move (killers[2])
+                    && move != unpack_move (killers[3])
+                    && move != unpack_move (killers[4])
+                    && move != unpack_move (killers[5]))
                 {
                     return move;
                 }
@@ -395,15 +467,17 @@ Move MovePicker::next_move<false> ()
             break;
 
         case BAD_CAPTURES_S1:
-            return (cur--)->move;
+            return unpack_move (*(cur--));
 
         case EVASIONS_S2:
+#ifndef MVVLVA
         case CAPTURES_S3:
         case CAPTURES_S4:
+#endif
             do
             {
                 pick_best ();
-                move = (cur++)->move;
+                move = unpack_move (*(cur++));
                 if (move != tt_move)
                 {
                     return move;
@@ -412,11 +486,26 @@ Move MovePicker::next_move<false> ()
             while (cur < end);
             break;
 
+#ifdef MVVLVA
+        case CAPTURES_S3:
+        case CAPTURES_S4:
+            while (qs_cur < qs_end)
+            {
+                move = (qs_cur++)->move;
+                if (move != tt_move)
+                {
+                    return move;
+                }
+            }
+            cur = end;
+            break;
+#endif
+
         case CAPTURES_S5:
             do
             {
                 pick_best ();
-                move = (cur++)->move;
+                move = unpack_move (*(cur++));
                 if (move != tt_move && pos.see (move) > capture_threshold)
                 {
                     return move;
@@ -426,22 +515,34 @@ Move MovePicker::next_move<false> ()
             break;
 
         case CAPTURES_S6:
+#ifdef MVVLVA
+            while (qs_cur < qs_end)
+            {
+                move = (qs_cur++)->move;
+                if (dst_sq (move) == recapture_sq)
+                {
+                    return move;
+                }
+            }
+            cur = end;
+#else
             do
             {
                 pick_best ();
-                move = (cur++)->move;
+                move = unpack_move (*(cur++));
                 if (dst_sq (move) == recapture_sq)
                 {
                     return move;
                 }
             }
             while (cur < end);
+#endif
             break;
 
         case QUIET_CHECKS_S3:
             do
             {
-                move = (cur++)->move;
+                move = unpack_move (*(cur++));
                 if (move != tt_move)
                 {
                     return move;
@@ -68,6 +68,17 @@ typedef Stats< true,                Value  > GainsStats;
 typedef Stats<false,                Value  > HistoryStats;
 typedef Stats<false, std::pair<Move, Move> > MovesStats;
 
+// PackedMove packs the move ordering score over the move in 32 bits (score << 16 | move).
+// The score is biased to unsigned so the high halves compare as the scores do, and the
+// picker sorts and picks plain integers.
+typedef u32 PackedMove;
+
+inline PackedMove pack_move (Move m, Value v) { return (PackedMove (i32 (v) + 0x8000) << 16) | PackedMove (m); }
+inline Move     unpack_move (PackedMove pm)   { return Move (pm & 0xFFFF); }
+
+// Packed moves are ordered by the score alone, equal scores keep the order of generation
+inline bool packed_less (PackedMove pm1, PackedMove pm2) { return (pm1 >> 16) < (pm2 >> 16); }
+
 
 // MovePicker class is used to pick one pseudo legal move at a time from the
 // current position. The most important method is next_move(), which returns a
@@ -92,11 +103,17 @@ private:
 
     };
 
-    ValMove  moves[MAX_MOVES]
-        ,   *cur
-        ,   *end
-        ,   *quiets_end
-        ,   *bad_captures_end;
+    ValMove     moves[MAX_MOVES]; // Moves generated for the stage
+#ifdef MVVLVA
+    ValMove    *qs_cur            // Quiescence captures read in generated (MVV/LVA) order
+        ,      *qs_end;
+#endif
+
+    PackedMove  packs[MAX_MOVES]  // Moves of the stage packed with their score
+        ,      *cur
+        ,      *end
+        ,      *quiets_end
+        ,      *bad_captures_end;
 
     const Position     &pos;
 
@@ -104,7 +121,7 @@ private:
 
     Searcher::Stack    *ss;
 
-    ValMove killers[6];
+    PackedMove killers[6];
     Move   *counter_moves;
     Move   *followup_moves;
 
@@ -116,23 +133,27 @@ private:
     Value   capture_threshold;
 
     u08     stage;
+    // Moves still to pick one at a time before sorting the rest of the stage
+    u08     lazy_picks;
 
     MovePicker& operator= (const MovePicker &); // Silence a warning under MSVC
 
     template<MoveGenerator::GenT>
-    // value() assign a numerical move ordering score to each move in a move list.
+    // value() packs the generated moves with their move ordering score, in one pass.
     // The moves with highest scores will be picked first.
-    void value ();
+    void value (const ValMove *moves_end);
+    // pack() packs the generated moves with no score, for the moves not to be ordered.
+    void pack (const ValMove *moves_end);
 
     void generate_next_stage ();
 
     // Our insertion sort, guaranteed to be stable, as is needed
     inline void insertion_sort ()
     {
-        for (ValMove *p = cur + 1; p < end; ++p)
+        for (PackedMove *p = cur + 1; p < end; ++p)
         {
-            ValMove tmp = *p, *q;
-            for (q = p; q != cur && *(q-1) < tmp; --q)
+            PackedMove tmp = *p, *q;
+            for (q = p; q != cur && packed_less (*(q-1), tmp); --q)
             {
                 *q = *(q-1);
             }
@@ -147,7 +168,23 @@ private:
     {
         if (cur < end-1)
         {
-            std::swap (*cur, *std::max_element (cur, end));
+            std::swap (*cur, *std::max_element (cur, end, packed_less));
+        }
+    }
+
+    // Picks and moves to the front the best move in the range [cur, end], keeping
+    // the order of the others, as the stable sort of the range would do.
+    inline void pick_first ()
+    {
+        if (cur < end-1)
+        {
+            PackedMove *p = std::max_element (cur, end, packed_less);
+            PackedMove best = *p;
+            for (; p != cur; --p)
+            {
+                *p = *(p-1);
+            }
+            *cur = best;
         }
     }
 
@@ -0,0 +1,247 @@
+#include "Network.h"
+
+#include <fstream>
+
+#include "Position.h"
+#include "BitScan.h"
+#include "UCI.h"
+#include "Thread.h"
+
+#if defined(__AVX2__)
+#   include <immintrin.h>
+#   define NETWORK_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   include <emmintrin.h>
+#   define NETWORK_SSE2
+#endif
+
+namespace Network {
+
+    using namespace std;
+
+    bool Active     = false;
+    u32  Generation = 0;
+
+    namespace {
+
+        // Quantization of the first layer and of the output layer,
+        // and the scale of the output to centipawns.
+        const i32 QA    = 255
+            ,     QB    = 64
+            ,     SCALE = 400;
+
+        CACHE_ALIGN(64) i16 FeatureWeights[INPUTS * HIDDEN];
+        CACHE_ALIGN(64) i16 FeatureBiases [HIDDEN];
+        CACHE_ALIGN(64) i16 OutputWeights [2 * HIDDEN];
+        i16 OutputBias;
+
+        string Loaded; // Filename of the loaded network, empty if none
+
+        // Row of the feature weights of the piece on the square seen from the perspective
+        inline const i16* feature (Color perspective, Color c, PieceT pt, Square s)
+        {
+            return FeatureWeights
+                + (((c != perspective ? 6 : 0) + pt) * SQ_NO + rel_sq (perspective, s)) * HIDDEN;
+        }
+
+        // Kernels over a row of HIDDEN int16, the loads are unaligned as the
+        // accumulator lives inside the Position which is not aligned.
+
+        inline void add_row (i16 *acc, const i16 *w)
+        {
+#if defined(NETWORK_AVX2)
+            for (u16 i = 0; i < HIDDEN; i += 16)
+            {
+                __m256i *a = (__m256i*) (acc + i);
+                _mm256_storeu_si256 (a, _mm256_add_epi16 (_mm256_loadu_si256 (a), _mm256_loadu_si256 ((const __m256i*) (w + i))));
+            }
+#elif defined(NETWORK_SSE2)
+            for (u16 i = 0; i < HIDDEN; i += 8)
+            {
+                __m128i *a = (__m128i*) (acc + i);
+                _mm_storeu_si128 (a, _mm_add_epi16 (_mm_loadu_si128 (a), _mm_loadu_si128 ((const __m128i*) (w + i))));
+            }
+#else
+            for (u16 i = 0; i < HIDDEN; ++i) acc[i] += w[i];
+#endif
+        }
+
+        inline void sub_row (i16 *acc, const i16 *w)
+        {
+#if defined(NETWORK_AVX2)
+            for (u16 i = 0; i < HIDDEN; i += 16)
+            {
+                __m256i *a = (__m256i*) (acc + i);
+                _mm256_storeu_si256 (a, _mm256_sub_epi16 (_mm256_loadu_si256 (a), _mm256_loadu_si256 ((const __m256i*) (w + i))));
+            }
+#elif defined(NETWORK_SSE2)
+            for (u16 i = 0; i < HIDDEN; i += 8)
+            {
+                __m128i *a = (__m128i*) (acc + i);
+                _mm_storeu_si128 (a, _mm_sub_epi16 (_mm_loadu_si128 (a), _mm_loadu_si128 ((const __m128i*) (w + i))));
+            }
+#else
+            for (u16 i = 0; i < HIDDEN; ++i) acc[i] -= w[i];
+#endif
+        }
+
+        // A move is one pass over the accumulator instead of two
+        inline void add_sub_row (i16 *acc, const i16 *wa, const i16 *ws)
+        {
+#if defined(NETWORK_AVX2)
+            for (u16 i = 0; i < HIDDEN; i += 16)
+            {
+                __m256i *a = (__m256i*) (acc + i);
+                __m256i v = _mm256_add_epi16 (_mm256_loadu_si256 (a), _mm256_loadu_si256 ((const __m256i*) (wa + i)));
+                _mm256_storeu_si256 (a, _mm256_sub_epi16 (v, _mm256_loadu_si256 ((const __m256i*) (ws + i))));
+            }
+#elif defined(NETWORK_SSE2)
+            for (u16 i = 0; i < HIDDEN; i += 8)
+            {
+                __m128i *a = (__m128i*) (acc + i);
+                __m128i v = _mm_add_epi16 (_mm_loadu_si128 (a), _mm_loadu_si128 ((const __m128i*) (wa + i)));
+                _mm_storeu_si128 (a, _mm_sub_epi16 (v, _mm_loadu_si128 ((const __m128i*) (ws + i))));
+            }
+#else
+            for (u16 i = 0; i < HIDDEN; ++i) acc[i] += wa[i] - ws[i];
+#endif
+        }
+
+        // Clipped ReLU [0, QA] of the accumulator dot the output weights
+        inline i32 output (const i16 *acc, const i16 *w)
+        {
+#if defined(NETWORK_AVX2)
+            const __m256i zero = _mm256_setzero_si256 ();
+            const __m256i qa   = _mm256_set1_epi16 (QA);
+            __m256i sum = zero;
+            for (u16 i = 0; i < HIDDEN; i += 16)
+            {
+                __m256i v = _mm256_min_epi16 (_mm256_max_epi16 (_mm256_loadu_si256 ((const __m256i*) (acc + i)), zero), qa);
+                sum = _mm256_add_epi32 (sum, _mm256_madd_epi16 (v, _mm256_loadu_si256 ((const __m256i*) (w + i))));
+            }
+            __m128i s = _mm_add_epi32 (_mm256_castsi256_si128 (sum), _mm256_extracti128_si256 (sum, 1));
+            s = _mm_add_epi32 (s, _mm_shuffle_epi32 (s, 0x4E));
+            s = _mm_add_epi32 (s, _mm_shuffle_epi32 (s, 0xB1));
+            return _mm_cvtsi128_si32 (s);
+#elif defined(NETWORK_SSE2)
+            const __m128i zero = _mm_setzero_si128 ();
+            const __m128i qa   = _mm_set1_epi16 (QA);
+            __m128i sum = zero;
+            for (u16 i = 0; i < HIDDEN; i += 8)
+            {
+                __m128i v = _mm_min_epi16 (_mm_max_epi16 (_mm_loadu_si128 ((const __m128i*) (acc + i)), zero), qa);
+                sum = _mm_add_epi32 (sum, _mm_madd_epi16 (v, _mm_loadu_si128 ((const __m128i*) (w + i))));
+            }
+            sum = _mm_add_epi32 (sum, _mm_shuffle_epi32 (sum, 0x4E));
+            sum = _mm_add_epi32 (sum, _mm_shuffle_epi32 (sum, 0xB1));
+            return _mm_cvtsi128_si32 (sum);
+#else
+            i32 sum = 0;
+            for (u16 i = 0; i < HIDDEN; ++i)
+            {
+                sum += i32 (acc[i] < 0 ? 0 : acc[i] > QA ? QA : acc[i]) * w[i];
+            }
+            return sum;
+#endif
+        }
+
+        bool load (const string &fn)
+        {
+            ifstream ifs (fn, ios_base::in|ios_base::binary);
+            if (!ifs.is_open ()) return false;
+
+            // Trainers may pad the file up to a multiple of 64 bytes
+            const u64 size = (u64 (INPUTS) * HIDDEN + HIDDEN + 2 * HIDDEN + 1) * sizeof (i16);
+            ifs.seekg (0, ios_base::end);
+            u64 file_size = u64 (ifs.tellg ());
+            ifs.seekg (0, ios_base::beg);
+            if (file_size < size || size + 64 <= file_size) return false;
+
+            ifs.read ((char *) FeatureWeights, sizeof (FeatureWeights));
+            ifs.read ((char *) FeatureBiases , sizeof (FeatureBiases));
+            ifs.read ((char *) OutputWeights , sizeof (OutputWeights));
+            ifs.read ((char *) &OutputBias   , sizeof (OutputBias));
+            bool ok = !ifs.fail ();
+            ifs.close ();
+            return ok;
+        }
+
+    }
+
+    void add_piece    (Accumulator &acc, Color c, PieceT pt, Square s)
+    {
+        add_row (acc.values[WHITE], feature (WHITE, c, pt, s));
+        add_row (acc.values[BLACK], feature (BLACK, c, pt, s));
+    }
+    void remove_piece (Accumulator &acc, Color c, PieceT pt, Square s)
+    {
+        sub_row (acc.values[WHITE], feature (WHITE, c, pt, s));
+        sub_row (acc.values[BLACK], feature (BLACK, c, pt, s));
+    }
+    void move_piece   (Accumulator &acc, Color c, PieceT pt, Square s1, Square s2)
+    {
+        add_sub_row (acc.values[WHITE], feature (WHITE, c, pt, s2), feature (WHITE, c, pt, s1));
+        add_sub_row (acc.values[BLACK], feature (BLACK, c, pt, s2), feature (BLACK, c, pt, s1));
+    }
+
+    void refresh (Accumulator &acc, const Position &pos)
+    {
+        memcpy (acc.values[WHITE], FeatureBiases, sizeof (FeatureBiases));
+        memcpy (acc.values[BLACK], FeatureBiases, sizeof (FeatureBiases));
+
+        for (Color c = WHITE; c <= BLACK; ++c)
+        {
+            for (PieceT pt = PAWN; pt <= KING; ++pt)
+            {
+                Bitboard bb = pos.pieces (c, pt);
+                while (bb != U64 (0))
+                {
+                    add_piece (acc, c, pt, pop_lsq (bb));
+                }
+            }
+        }
+        acc.generation = Generation;
+    }
+
+    Value evaluate (const Position &pos)
+    {
+        const Accumulator &acc = pos.accumulator ();
+        Color c = pos.active ();
+
+        i64 out = i64 (output (acc.values[ c], OutputWeights))
+                + i64 (output (acc.values[~c], OutputWeights + HIDDEN))
+                + OutputBias;
+
+        // From centipawns, inside the known win bounds
+        i32 v = i32 (out * SCALE / (QA * QB)) * i32 (VALUE_MG_PAWN) / 100;
+        return Value (min (max (v, -i32 (VALUE_KNOWN_WIN)), +i32 (VALUE_KNOWN_WIN)));
+    }
+
+    void initialize ()
+    {
+        bool   use = bool (*(Options["Use Network"]));
+        string fn  = string (*(Options["Network File"]));
+
+        Active = false;
+        if (use)
+        {
+            if (fn != Loaded)
+            {
+                if (load (fn))
+                {
+                    Loaded = fn;
+                    sync_cout << "info string Network loaded from file \'" << fn << "\'." << sync_endl;
+                }
+                else
+                {
+                    Loaded.clear ();
+                    sync_cout << "info string Network file \'" << fn << "\' not loaded, classical evaluation is used." << sync_endl;
+                }
+            }
+            Active = !Loaded.empty ();
+        }
+        // Accumulators computed before are stale
+        ++Generation;
+    }
+
+}
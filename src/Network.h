@@ -0,0 +1,63 @@
+#ifdef _MSC_VER
+#   pragma once
+#endif
+
+#ifndef _NETWORK_H_INC_
+#define _NETWORK_H_INC_
+
+#include "Type.h"
+
+class Position;
+
+// Network is an alternative evaluation by a small neural network (NNUE-style),
+// selected with the "Use Network" option in place of the hand-written terms.
+//
+// Architecture: 768 -> 2x256 -> 1
+//  - The inputs are the (piece, square) pairs seen from each perspective:
+//    own and enemy pieces, squares flipped vertically for black.
+//  - The first layer output of each perspective is kept in an Accumulator,
+//    updated incrementally by the piece deltas of do_move() and undo_move().
+//  - Output is the clipped ReLU of the side to move accumulator followed by the
+//    other side one, dot the output weights, plus the output bias.
+//
+// Network file, raw little-endian 16-bit integers (as written by the usual
+// 768 -> N -> 1 perspective trainers):
+//  - Feature weights [768][256], quantized by QA
+//  - Feature biases  [256]      , quantized by QA
+//  - Output weights  [2 * 256]  , quantized by QB
+//  - Output bias               , quantized by QA * QB
+namespace Network {
+
+    const u16 INPUTS = 2 * 6 * 64;
+    const u16 HIDDEN = 256;
+
+    // Accumulator keeps the first layer of the network for both perspectives.
+    // 'generation' tells the network it was computed with, a stale one is
+    // refreshed from scratch when the position is evaluated.
+    struct Accumulator
+    {
+        i16 values[CLR_NO][HIDDEN];
+        u32 generation;
+    };
+
+    // Network is loaded and selected
+    extern bool Active;
+    // Incremented every time the network is loaded or selected
+    extern u32  Generation;
+
+    extern void add_piece    (Accumulator &acc, Color c, PieceT pt, Square s);
+    extern void remove_piece (Accumulator &acc, Color c, PieceT pt, Square s);
+    extern void move_piece   (Accumulator &acc, Color c, PieceT pt, Square s1, Square s2);
+
+    // refresh() computes the accumulator from scratch
+    extern void refresh (Accumulator &acc, const Position &pos);
+
+    // evaluate() returns the network evaluation from the side to move point of view
+    extern Value evaluate (const Position &pos);
+
+    // initialize() loads the network and selects it from the UCI options
+    extern void initialize ();
+
+}
+
+#endif // _NETWORK_H_INC_
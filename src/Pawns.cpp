@@ -4,6 +4,7 @@
 
 #include "BitBoard.h"
 #include "BitCount.h"
+#include "Thread.h"
 
 namespace Pawns {
 
@@ -82,7 +83,7 @@ namespace Pawns {
             };
 
             e->_passed_pawns  [C] = e->_candidate_pawns[C] = 0;
-            e->_king_sq       [C] = SQ_NO;
+            fill (e->_king_sq[C], e->_king_sq[C] + Entry::SAFETY_SLOTS, SQ_NO);
             e->_semiopen_files[C] = 0xFF;
             e->_pawn_attacks  [C] = shift_del<RCAP> (pawns[0]) | shift_del<LCAP> (pawns[0]);
             e->_pawn_count_sq [C][BLACK] = pop_count<MAX15> (pawns[0] & DARK_bb);
@@ -272,23 +273,53 @@ namespace Pawns {
     }
 
     template<Color C>
-    // Entry::update_safety() calculates and caches a bonus for king safety. It is
-    // called only when king square changes, about 20% of total king_safety() calls.
+    // Entry::king_safety() returns the king safety from the cache of the entry,
+    // or computes it when the king square and castle rights are not there.
+    Score Entry::king_safety (const Position &pos, Square king_sq)
+    {
+#ifndef NDEBUG
+        Table &table = pos.thread ()->pawns_table;
+        ++table.safety_probes;
+#endif
+
+        u08 cr = pos.can_castle (C);
+        for (u08 i = 0; i < SAFETY_SLOTS; ++i)
+        {
+            if (_king_sq[C][i] == king_sq && _castle_rights[C][i] == cr)
+            {
+#ifndef NDEBUG
+                ++table.safety_hits;
+#endif
+                return _king_safety[C][i];
+            }
+        }
+        return update_safety<C> (pos, king_sq);
+    }
+
+    template<Color C>
+    // Entry::update_safety() calculates a bonus for king safety and caches it
+    // in the first slot, the oldest one is dropped.
     Score Entry::update_safety (const Position &pos, Square king_sq)
     {
-        _king_sq[C] = king_sq;
-        _castle_rights[C] = pos.can_castle(C);
-        _kp_min_dist  [C] = 0;
+        for (u08 i = SAFETY_SLOTS - 1; i > 0; --i)
+        {
+            _king_sq      [C][i] = _king_sq      [C][i-1];
+            _castle_rights[C][i] = _castle_rights[C][i-1];
+            _king_safety  [C][i] = _king_safety  [C][i-1];
+        }
+        _king_sq      [C][0] = king_sq;
+        _castle_rights[C][0] = pos.can_castle (C);
 
+        u08 kp_min_dist = 0;
         Bitboard pawns = pos.pieces (C, PAWN);
         if (pawns)
         {
-            while (!(DistanceRings[king_sq][_kp_min_dist[C]++] & pawns));
+            while (!(DistanceRings[king_sq][kp_min_dist++] & pawns));
         }
 
         if (rel_rank(C, king_sq) > R_4)
         {
-            return _king_safety[C] = mk_score (0, -16 * _kp_min_dist[C]);
+            return _king_safety[C][0] = mk_score (0, -16 * kp_min_dist);
         }
 
         Value bonus = shelter_storm<C> (pos, king_sq);
@@ -303,11 +334,13 @@ namespace Pawns {
             bonus = max (bonus, shelter_storm<C> (pos, rel_sq (C, SQ_WK_Q)));
         }
 
-        return _king_safety[C] = mk_score (bonus, -16 * _kp_min_dist[C]);
+        return _king_safety[C][0] = mk_score (bonus, -16 * kp_min_dist);
     }
 
     // Explicit template instantiation
     // -------------------------------
+    template Score Entry::king_safety<WHITE> (const Position &pos, Square king_sq);
+    template Score Entry::king_safety<BLACK> (const Position &pos, Square king_sq);
     template Score Entry::update_safety<WHITE> (const Position &pos, Square king_sq);
     template Score Entry::update_safety<BLACK> (const Position &pos, Square king_sq);
 
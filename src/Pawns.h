@@ -16,8 +16,12 @@ namespace Pawns {
     // bitboard of passed pawns. We may want to add further information in the future.
     // A lookup to the pawn hash table (performed by calling the probe function)
     // returns a pointer to an Entry object.
+    // The king safety depends only on the pawns, the king square and the castle rights,
+    // so the entry keeps it for the last few king squares of each color.
     struct Entry
     {
+        static const u08 SAFETY_SLOTS = 4;
+
         Key     _pawn_key;
         Score   _pawn_score;
 
@@ -25,13 +29,13 @@ namespace Pawns {
         Bitboard _passed_pawns   [CLR_NO];
         Bitboard _candidate_pawns[CLR_NO];
         
-        Square _king_sq       [CLR_NO];
         // Count of pawns on LIGHT and DARK squares
         u08   _pawn_count_sq  [CLR_NO][CLR_NO];
-        u08   _kp_min_dist    [CLR_NO];
-        u08   _castle_rights  [CLR_NO];
         u08   _semiopen_files [CLR_NO];
-        Score _king_safety    [CLR_NO];
+        // King safety cache, most recently computed first (hits are not moved)
+        Square _king_sq       [CLR_NO][SAFETY_SLOTS];
+        u08   _castle_rights  [CLR_NO][SAFETY_SLOTS];
+        Score _king_safety    [CLR_NO][SAFETY_SLOTS];
 
         inline Score    pawn_score()             const { return _pawn_score; }
         inline Bitboard pawn_attacks   (Color c) const { return _pawn_attacks[c]; }
@@ -51,11 +55,7 @@ namespace Pawns {
         }
 
         template<Color C>
-        inline Score king_safety (const Position &pos, Square k_sq)
-        {
-            return (_king_sq[C] == k_sq && _castle_rights[C] == pos.can_castle (C))
-                ? _king_safety[C] : update_safety<C> (pos, k_sq);
-        }
+        Score king_safety (const Position &pos, Square k_sq);
 
         template<Color C>
         Score update_safety (const Position &pos, Square k_sq);
@@ -66,7 +66,19 @@ namespace Pawns {
     };
 
 
-    typedef HashTable<Entry, 16384> Table;
+    // Pawns hash table, one per thread, with the statistics of the king safety cache
+    // (counted only in debug builds)
+    struct Table
+        : public HashTable<Entry, 16384>
+    {
+        u64 safety_probes
+          , safety_hits;
+
+        Table ()
+            : safety_probes (0)
+            , safety_hits (0)
+        {}
+    };
 
     extern void initialize ();
 
@@ -119,6 +119,17 @@ typedef        uint64_t    u64;
 
 #endif
 
+// Thread local storage, MSVC before 2015 has no C++11 thread_local
+#ifdef _MSC_VER
+
+#   define THREAD_LOCAL       __declspec(thread)
+
+#else
+
+#   define THREAD_LOCAL       thread_local
+
+#endif
+
 // ---
 
 #undef ASSERT
@@ -35,14 +35,12 @@ const Value PieceValue[PHASE_NO][TOTL] =
 const string FEN_N ("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
 const string FEN_X ("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w HAha - 0 1");
 
-#ifndef NDEBUG
 bool _ok (const   char *fen, bool c960, bool full)
 {
     if (!fen)   return false;
     Position pos (0);
     return Position::parse (pos, fen, NULL, c960, full) && pos.ok ();
 }
-#endif
 
 bool _ok (const string &fen, bool c960, bool full)
 {
@@ -57,8 +55,72 @@ namespace {
     // calculate the quad words (64bits) needed to be copied.
     const u08 STATE_COPY_SIZE = offsetof (StateInfo, posi_key);
 
+    // Castling data of all the castling setups, built once by initialize() and only read after,
+    // so the positions of all the threads share them without any lock.
+    // The setup of a color is the file of its king and the files of its king-side and
+    // queen-side castling rooks (F_NO if none), CastleSetups numbers them, 0 is no castling.
+    const u08 CASTLE_SETUPS = 113;
+
+    u08        CastleSetups[F_NO][i08 (F_NO) + 1][i08 (F_NO) + 1];
+    CastleInfo CastleInfos[CASTLE_SETUPS][CASTLE_SETUPS];
+
+    // add_castle() adds the castling of the color with the king and the rook on the given files
+    void add_castle (CastleInfo &castle, Color c, File king_f, File rook_f)
+    {
+        Square org_king = king_f | rel_rank (c, R_1);
+        Square org_rook = rook_f | rel_rank (c, R_1);
+
+        bool king_side = (org_rook > org_king);
+        CRight cr = mk_castle_right (c, king_side ? CS_K : CS_Q);
+        Square dst_rook = rel_sq (c, king_side ? SQ_WR_K : SQ_WR_Q);
+        Square dst_king = rel_sq (c, king_side ? SQ_WK_K : SQ_WK_Q);
+
+        castle.castle_mask[org_king] |= cr;
+        castle.castle_mask[org_rook] |= cr;
+        castle.castle_rook[cr] = org_rook;
+
+        for (Square s = min (org_rook, dst_rook); s <= max (org_rook, dst_rook); ++s)
+        {
+            if (org_king != s && org_rook != s)
+            {
+                castle.castle_path[cr] += s;
+            }
+        }
+        for (Square s = min (org_king, dst_king); s <= max (org_king, dst_king); ++s)
+        {
+            if (org_king != s && org_rook != s)
+            {
+                castle.castle_path[cr] += s;
+            }
+        }
+    }
+
+    // shared_castle() returns the shared castling data of the castling rooks
+    const CastleInfo* shared_castle (const Position &pos, const File rooks[CLR_NO][CS_NO])
+    {
+        u08 setup[CLR_NO];
+        for (Color c = WHITE; c <= BLACK; ++c)
+        {
+            setup[c] = pos.can_castle (c)
+                ? CastleSetups[_file (pos.king_sq (c))][rooks[c][CS_K]][rooks[c][CS_Q]] : 0;
+        }
+        return &CastleInfos[setup[WHITE]][setup[BLACK]];
+    }
+
     CACHE_ALIGN(64) Score PSQ[CLR_NO][NONE][SQ_NO];
 
+    // Cuckoo tables of the reversible moves of the pieces (not pawns) on an empty board,
+    // keyed by the change of the position key the move makes. A move and its reverse
+    // share one entry. Used by upcoming_repetition() to find the move going back to
+    // an earlier position of the path.
+    const u16 CUCKOO_SIZE = 0x2000;
+
+    Key  CuckooKeys [CUCKOO_SIZE];
+    Move CuckooMoves[CUCKOO_SIZE];
+
+    inline u16 cuckoo_h1 (Key key) { return u16 (key >>  0) & (CUCKOO_SIZE - 1); }
+    inline u16 cuckoo_h2 (Key key) { return u16 (key >> 16) & (CUCKOO_SIZE - 1); }
+
 #define S(mg, eg) mk_score (mg, eg)
     // PSQT[PieceType][Square] contains Piece-Square scores. For each piece type on
     // a given square a (midgame, endgame) score pair is assigned. PSQT is defined
@@ -194,6 +256,76 @@ void Position::initialize ()
             PSQ[BLACK][pt][~s] = -psq_score;
         }
     }
+
+    fill (CuckooKeys , CuckooKeys  + CUCKOO_SIZE, U64 (0));
+    fill (CuckooMoves, CuckooMoves + CUCKOO_SIZE, MOVE_NONE);
+    for (Color c = WHITE; c <= BLACK; ++c)
+    {
+        for (PieceT pt = NIHT; pt <= KING; ++pt)
+        {
+            for (Square s1 = SQ_A1; s1 <= SQ_H8; ++s1)
+            {
+                for (Square s2 = Square (s1 + 1); s2 <= SQ_H8; ++s2)
+                {
+                    if (!(PieceAttacks[pt][s1] & s2)) continue;
+
+                    Move move = mk_move<NORMAL> (s1, s2);
+                    Key  key  = Zob._.piecesq[c][pt][s1] ^ Zob._.piecesq[c][pt][s2] ^ Zob._.mover_side;
+                    u16  i    = cuckoo_h1 (key);
+                    // Insert, kicking the entry there to its other slot until an empty one
+                    while (true)
+                    {
+                        swap (CuckooKeys [i], key);
+                        swap (CuckooMoves[i], move);
+                        if (MOVE_NONE == move) break;
+                        i = (i == cuckoo_h1 (key)) ? cuckoo_h2 (key) : cuckoo_h1 (key);
+                    }
+                }
+            }
+        }
+    }
+
+    // Number the castling setups of a color, the rooks on the sides of the king
+    File setups[CASTLE_SETUPS][3]; // King, king-side rook, queen-side rook
+    u08 n = 1;
+    for (File k = F_A; k <= F_H; ++k)
+    {
+        for (File rk = F_A; rk <= F_NO; ++rk)
+        {
+            for (File rq = F_A; rq <= F_NO; ++rq)
+            {
+                CastleSetups[k][rk][rq] = 0;
+                if (   (F_NO == rk && F_NO == rq)
+                    || (F_NO != rk && rk <= k)
+                    || (F_NO != rq && rq >= k))
+                {
+                    continue;
+                }
+                CastleSetups[k][rk][rq] = n;
+                setups[n][0] = k;
+                setups[n][1] = rk;
+                setups[n][2] = rq;
+                ++n;
+            }
+        }
+    }
+    ASSERT (n == CASTLE_SETUPS);
+    // Castling data of all the pairs of white and black setups
+    for (u08 w = 0; w < CASTLE_SETUPS; ++w)
+    {
+        for (u08 b = 0; b < CASTLE_SETUPS; ++b)
+        {
+            CastleInfo &castle = CastleInfos[w][b];
+            castle = CastleInfo ();
+            for (Color c = WHITE; c <= BLACK; ++c)
+            {
+                u08 i = (WHITE == c) ? w : b;
+                if (0 == i) continue;
+                if (F_NO != setups[i][1]) add_castle (castle, c, setups[i][0], setups[i][1]);
+                if (F_NO != setups[i][2]) add_castle (castle, c, setups[i][0], setups[i][2]);
+            }
+        }
+    }
 }
 
 // operator= (pos), copy the 'pos'.
@@ -201,7 +333,9 @@ void Position::initialize ()
 // so that why detach the state info pointer from the source one.
 Position& Position::operator= (const Position &pos)
 {
-    memcpy (this, &pos, sizeof (Position));
+    // The network layer is last and is copied only when the network is active,
+    // otherwise selecting the network bumps its generation and it is refreshed then.
+    memcpy (this, &pos, copy_size ());
 
     _sb = *_si;
     _si = &_sb;
@@ -231,8 +365,10 @@ bool Position::draw () const
     }
 
     // Draw by Threefold Repetition?
+    // Only when the position is counted more than once on the path of the thread
     const StateInfo *psi = _si;
     u08 ply = min (_si->null_ply, _si->clock50);
+    if (ply >= 4 && _thread != NULL && !_thread->repetitions.repeatable (_si->posi_key)) ply = 0;
     while (ply >= 2)
     {
         //psi = psi->p_si; if (psi == NULL) break; 
@@ -279,6 +415,57 @@ bool Position::repeated () const
     return false;
 }
 
+// upcoming_repetition() tests whether the side to move has a move going back to an earlier
+// position of the path since the last irreversible move, a draw by repetition at hand.
+// It finds the moves in the cuckoo tables from the changes of the key between
+// the position and the earlier ones, so no move is generated.
+// Only the repetitions within the search tree (less than 'ply' plies back) are detected.
+bool Position::upcoming_repetition (i32 ply) const
+{
+    i32 end = min (_si->clock50, _si->null_ply);
+    if (end < 3) return false;
+
+    Key posi_k = _si->posi_key;
+    const StateInfo *psi = _si->p_si;
+    for (i32 i = 3; i <= end && i < ply; i += 2)
+    {
+        psi = psi->p_si->p_si;
+
+        Key move_key = posi_k ^ psi->posi_key;
+        u16 j = cuckoo_h1 (move_key);
+        if (CuckooKeys[j] != move_key)
+        {
+            j = cuckoo_h2 (move_key);
+            if (CuckooKeys[j] != move_key) continue;
+        }
+
+        Move m = CuckooMoves[j];
+        if (!(Between_bb[org_sq (m)][dst_sq (m)] & _types_bb[NONE]))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// count_path() adds (or removes) the keys of the positions since the last irreversible
+// move to the repetition table of the thread, for the position to be searched there.
+void Position::count_path (bool add) const
+{
+    if (_thread == NULL) return;
+
+    RepetitionTable &repetitions = _thread->repetitions;
+    const StateInfo *psi = _si;
+    i32 ply = min (_si->clock50, _si->null_ply);
+    while (true)
+    {
+        add ? repetitions.add (psi->posi_key) : repetitions.remove (psi->posi_key);
+        if (ply < 1 || psi->p_si == NULL) break;
+        psi = psi->p_si;
+        --ply;
+    }
+}
+
 // Position consistency test, for debugging
 bool Position::ok (i08 *step) const
 {
@@ -297,6 +484,10 @@ bool Position::ok (i08 *step) const
     const bool test_posi_key      = test_all || false;
     const bool test_inc_eval      = test_all || false;
     const bool test_np_material   = test_all || false;
+#ifdef ATTACKMAP
+    const bool test_attack_maps   = test_all || false;
+#endif
+    const bool test_accumulator   = test_all || false;
 
     if (step) *step = 1;
     // step 1
@@ -477,9 +668,9 @@ bool Position::ok (i08 *step) const
 
                 if (!can_castle (cr)) continue;
 
-                if ( (_castle_mask[_piece_list[c][KING][0]] & cr) != cr
-                  || (_board[_castle_rook[cr]] != (c | ROOK))
-                  || (_castle_mask[_castle_rook[cr]] != cr))
+                if ( (_castle->castle_mask[_piece_list[c][KING][0]] & cr) != cr
+                  || (_board[_castle->castle_rook[cr]] != (c | ROOK))
+                  || (_castle->castle_mask[_castle->castle_rook[cr]] != cr))
                 {
                     return false;
                 }
@@ -525,6 +716,30 @@ bool Position::ok (i08 *step) const
             return false;
         }
     }
+#ifdef ATTACKMAP
+    // step 14
+    if (step && ++(*step), test_attack_maps)
+    {
+        for (Square s = SQ_A1; s <= SQ_H8; ++s)
+        {
+            if (   _attacks  [s] != ((EMPTY != _board[s]) ? compute_attacks (s) : U64 (0))
+                || _attackers[s] != attackers_to (s))
+            {
+                return false;
+            }
+        }
+    }
+#endif
+    // step 15
+    if (step && ++(*step), test_accumulator)
+    {
+        if (Network::Active && _accumulator.generation == Network::Generation)
+        {
+            Network::Accumulator acc;
+            Network::refresh (acc, *this);
+            if (memcmp (acc.values, _accumulator.values, sizeof (acc.values)) != 0) return false;
+        }
+    }
 
     return true;
 }
@@ -598,7 +813,23 @@ Value Position::see (Move m) const
 
     // Find all enemy attackers to the destination square, with the moving piece
     // removed, but possibly an X-ray attacker added behind it.
+#ifdef ATTACKMAP
+    // The attack maps give the attackers on the full board, only the sliders
+    // behind the removed pieces (moving piece, en-passant pawn) are to be added.
+    Bitboard removed   = _types_bb[NONE] & ~occupied;
+    Bitboard attackers = _attackers[dst];
+    if (PieceAttacks[BSHP][dst] & removed)
+    {
+        attackers |= attacks_bb<BSHP> (dst, occupied) & (_types_bb[BSHP]|_types_bb[QUEN]);
+    }
+    if (PieceAttacks[ROOK][dst] & removed)
+    {
+        attackers |= attacks_bb<ROOK> (dst, occupied) & (_types_bb[ROOK]|_types_bb[QUEN]);
+    }
+    attackers &= occupied;
+#else
     Bitboard attackers = attackers_to (dst, occupied) & occupied;
+#endif
 
     // If the opponent has no attackers we are finished
     stm = ~stm;
@@ -1044,6 +1275,13 @@ bool Position::gives_check  (Move m, const CheckInfo &ci) const
         // already handled the case of direct checks and ordinary discovered check,
         // the only case need to handle is the unusual case of a discovered check through the captured pawn.
         Square cap = _file (dst) | _rank (org);
+#ifdef ATTACKMAP
+        // No discovered check unless a friend slider attacks 'org' or 'cap'
+        if (!((_attackers[org] | _attackers[cap]) & _color_bb[_active] & (_types_bb[BSHP]|_types_bb[ROOK]|_types_bb[QUEN])))
+        {
+            return false;
+        }
+#endif
         Bitboard mocc = occ - org - cap + dst;
         // if any attacker then in check
         return (attacks_bb<ROOK> (ci.king_sq, mocc) & (_color_bb[_active]&(_types_bb[QUEN]|_types_bb[ROOK])))
@@ -1065,6 +1303,13 @@ bool Position::gives_checkmate (Move m, const CheckInfo &ci) const
     return (MoveList<LEGAL> (pos).size () == 0);
 }
 
+CastleInfo::CastleInfo ()
+{
+    memset (castle_mask, 0, sizeof (castle_mask));
+    memset (castle_rook, SQ_NO, sizeof (castle_rook));
+    memset (castle_path, 0, sizeof (castle_path));
+}
+
 // clear() clear the position
 void Position::clear ()
 {
@@ -1086,8 +1331,7 @@ void Position::clear ()
         }
     }
 
-    //fill (_castle_rook, _castle_rook + sizeof (_castle_rook) / sizeof (*_castle_rook), SQ_NO);
-    memset (_castle_rook, SQ_NO, sizeof (_castle_rook));
+    _castle = &CastleInfos[0][0];
 
     //_game_ply   = 1;
 
@@ -1096,7 +1340,6 @@ void Position::clear ()
     _si = &_sb;
 }
 // setup() sets the fen on the position
-#ifndef NDEBUG
 bool Position::setup (const   char *f, Thread *th, bool c960, bool full)
 {
     //Position pos (0);
@@ -1109,7 +1352,6 @@ bool Position::setup (const   char *f, Thread *th, bool c960, bool full)
 
     return parse (*const_cast<Position*> (this), f, th, c960, full);
 }
-#endif
 bool Position::setup (const string &f, Thread *th, bool c960, bool full)
 {
     //Position pos (0);
@@ -1122,38 +1364,27 @@ bool Position::setup (const string &f, Thread *th, bool c960, bool full)
 
     return parse (*const_cast<Position*> (this), f, th, c960, full);
 }
+// setup() sets the packed position on the position
+bool Position::setup (const PackedPosition &pp, Thread *th, bool c960)
+{
+    return parse (*this, pp, th, c960);
+}
 
-// set_castle() set the castling for the particular color & rook
-void Position::set_castle (Color c, Square org_rook)
+// set_castle() sets the castling right of the color with the rook,
+// if the king and the rook are on the first rank of the color.
+void Position::set_castle (Color c, Square org_rook, File rooks[CLR_NO][CS_NO])
 {
     Square org_king = _piece_list[c][KING][0];
-    ASSERT (org_king != org_rook);
-
-    bool king_side = (org_rook > org_king);
-    CRight cr = mk_castle_right (c, king_side ? CS_K : CS_Q);
-    Square dst_rook = rel_sq (c, king_side ? SQ_WR_K : SQ_WR_Q);
-    Square dst_king = rel_sq (c, king_side ? SQ_WK_K : SQ_WK_Q);
-
-    _si->castle_rights |= cr;
-
-    _castle_mask[org_king] |= cr;
-    _castle_mask[org_rook] |= cr;
-    _castle_rook[cr] = org_rook;
-
-    for (Square s = min (org_rook, dst_rook); s <= max (org_rook, dst_rook); ++s)
-    {
-        if (org_king != s && org_rook != s)
-        {
-            _castle_path[cr] += s;
-        }
-    }
-    for (Square s = min (org_king, dst_king); s <= max (org_king, dst_king); ++s)
+    if (   rel_rank (c, org_king) != R_1
+        || rel_rank (c, org_rook) != R_1
+        || org_king == org_rook)
     {
-        if (org_king != s && org_rook != s)
-        {
-            _castle_path[cr] += s;
-        }
+        return;
     }
+
+    CSide cs = (org_rook > org_king) ? CS_K : CS_Q;
+    _si->castle_rights |= mk_castle_right (c, cs);
+    rooks[c][cs] = _file (org_rook);
 }
 // can_en_passant() tests the en-passant square
 bool Position::can_en_passant (Square ep_sq) const
@@ -1225,6 +1456,46 @@ Value Position::compute_non_pawn_material (Color c) const
     return value;
 }
 
+#ifdef ATTACKMAP
+// compute_attacks() computes from scratch the attacks of the piece on the square.
+Bitboard Position::compute_attacks (Square s) const
+{
+    Piece  p  = _board[s];
+    PieceT pt = ptype (p);
+    return (PAWN == pt) ? PawnAttacks[color (p)][s]
+        :  (NIHT == pt || KING == pt) ? PieceAttacks[pt][s]
+        :  (BSHP == pt || ROOK == pt || QUEN == pt) ? attacks_bb (p, s, _types_bb[NONE])
+        :  U64 (0);
+}
+
+// update_attacks() refreshes the attack maps after the pieces on the 'changed'
+// squares have been placed, removed or moved. Only the pieces on those squares
+// and the sliders whose attacks reach them (rays blocked or unblocked) change,
+// the attackers map is patched with the difference of their attacks.
+void Position::update_attacks (Bitboard changed)
+{
+    Bitboard refresh = changed;
+    Bitboard sliders = (_types_bb[BSHP]|_types_bb[ROOK]|_types_bb[QUEN]) & ~changed;
+    while (sliders != U64 (0))
+    {
+        Square s = pop_lsq (sliders);
+        if (_attacks[s] & changed) refresh += s;
+    }
+
+    while (refresh != U64 (0))
+    {
+        Square s = pop_lsq (refresh);
+        Bitboard attacks = (EMPTY != _board[s]) ? compute_attacks (s) : U64 (0);
+        Bitboard diff    = attacks ^ _attacks[s];
+        _attacks[s] = attacks;
+        while (diff != U64 (0))
+        {
+            _attackers[pop_lsq (diff)] ^= s;
+        }
+    }
+}
+#endif
+
 // do_move() do the move with checking info
 void Position::do_move (Move m, StateInfo &n_si, const CheckInfo *ci)
 {
@@ -1358,6 +1629,10 @@ void Position::do_move (Move m, StateInfo &n_si, const CheckInfo *ci)
         _si->en_passant_sq = SQ_NO;
     }
 
+#ifdef ATTACKMAP
+    Bitboard changed = Square_bb[org] | Square_bb[dst] | Square_bb[cap];
+#endif
+
     // Do move according to move type
     if      (mt == NORMAL
         ||   mt == ENPASSANT)
@@ -1381,6 +1656,9 @@ void Position::do_move (Move m, StateInfo &n_si, const CheckInfo *ci)
     {
         Square org_rook, dst_rook;
         do_castling<true>(org, dst, org_rook, dst_rook);
+#ifdef ATTACKMAP
+        changed |= Square_bb[dst] | Square_bb[dst_rook];
+#endif
 
         posi_k ^= Zob._.piecesq[_active][KING][org     ] ^ Zob._.piecesq[_active][KING][dst     ];
         posi_k ^= Zob._.piecesq[_active][ROOK][org_rook] ^ Zob._.piecesq[_active][ROOK][dst_rook];
@@ -1410,7 +1688,7 @@ void Position::do_move (Move m, StateInfo &n_si, const CheckInfo *ci)
     }
 
     // Update castle rights if needed
-    u08 cr = _si->castle_rights & (_castle_mask[org] | _castle_mask[dst]);
+    u08 cr = _si->castle_rights & (_castle->castle_mask[org] | _castle->castle_mask[dst]);
     if (cr)
     {
         Bitboard b = cr;
@@ -1421,6 +1699,13 @@ void Position::do_move (Move m, StateInfo &n_si, const CheckInfo *ci)
         }
     }
 
+#ifdef ATTACKMAP
+    update_attacks (changed);
+
+    // Update checkers bitboard: directly from the attack maps
+    (void) ci;
+    _si->checkers = _attackers[_piece_list[pasive][KING][0]] & _color_bb[_active];
+#else
     // Update checkers bitboard: piece must be already moved due to attacks_bb()
     _si->checkers = U64 (0);
     if (ci != NULL)
@@ -1457,6 +1742,7 @@ void Position::do_move (Move m, StateInfo &n_si, const CheckInfo *ci)
             _si->checkers = attackers_to (_piece_list[pasive][KING][0]) & _color_bb[_active];
         }
     }
+#endif
 
     // Switch side to move
     _active = pasive;
@@ -1495,12 +1781,19 @@ void Position::do_move (Move m, StateInfo &n_si, const CheckInfo *ci)
     ++_game_ply;
     ++_game_nodes;
 
+    if (_thread) _thread->repetitions.add (posi_k);
+
     ASSERT (ok ());
 }
 void Position::do_move (Move m, StateInfo &n_si)
 {
+#ifdef ATTACKMAP
+    // Checkers come from the attack maps, no need of the check info
+    do_move (m, n_si, NULL);
+#else
     CheckInfo ci (*this);
     do_move (m, n_si, gives_check (m, ci) ? &ci : NULL);
+#endif
 }
 // do_move() do the move from string (CAN)
 void Position::do_move (string &can, StateInfo &n_si)
@@ -1508,6 +1801,17 @@ void Position::do_move (string &can, StateInfo &n_si)
     Move move = move_from_can (can, *this);
     if (MOVE_NONE != move) do_move (move, n_si);
 }
+// copy_move() copies the position on the given one and makes the move there (copy-make).
+// This position is left untouched so there is nothing to undo, the copy links its state
+// to the current state of this position, so this must outlive the copy.
+// The nodes visited are counted on the copy, from the ones of this position.
+void Position::copy_move (Move m, Position &pos, StateInfo &n_si, const CheckInfo *ci) const
+{
+    ASSERT (&pos != this);
+
+    memcpy (static_cast<void*> (&pos), this, copy_size ());
+    pos.do_move (m, n_si, ci);
+}
 // undo_move() undo the last move
 void Position::undo_move ()
 {
@@ -1536,6 +1840,9 @@ void Position::undo_move ()
     {
         Square org_rook, dst_rook;
         do_castling<false>(org, dst, org_rook, dst_rook);
+#ifdef ATTACKMAP
+        update_attacks (Square_bb[org] | Square_bb[dst] | Square_bb[org_rook] | Square_bb[dst_rook]);
+#endif
         //ct  = NONE;
     }
     else if (mt == PROMOTE)
@@ -1566,6 +1873,15 @@ void Position::undo_move ()
         place_piece (cap, ~_active, _si->capture_type); // Restore the captured piece
     }
 
+#ifdef ATTACKMAP
+    if (mt != CASTLE)
+    {
+        update_attacks (Square_bb[org] | Square_bb[dst] | Square_bb[cap]);
+    }
+#endif
+
+    if (_thread) _thread->repetitions.remove (_si->posi_key);
+
     --_game_ply;
     // Finally point our state pointer back to the previous state
     _si     = _si->p_si;
@@ -1600,6 +1916,8 @@ void Position::do_null_move (StateInfo &n_si)
     _si->clock50++;
     _si->null_ply = 0;
 
+    if (_thread) _thread->repetitions.add (_si->posi_key);
+
     ASSERT (ok ());
 }
 // undo_null_move() undo the last null-move
@@ -1608,6 +1926,8 @@ void Position::undo_null_move ()
     ASSERT (_si->p_si);
     ASSERT (!_si->checkers);
 
+    if (_thread) _thread->repetitions.remove (_si->posi_key);
+
     _active = ~_active;
     _si     = _si->p_si;
 
@@ -1648,14 +1968,14 @@ void Position::flip ()
     ASSERT (ok ());
 }
 
-#ifndef NDEBUG
-bool   Position::fen (const char *fn, bool c960, bool full) const
+// fen() writes the fen of the position in the buffer (at least FEN_LEN + 1 chars), no allocation
+bool   Position::fen (char *fn, bool c960, bool full) const
 {
     ASSERT (fn);
     ASSERT (ok ());
 
-    char *ch = const_cast<char *> (fn);
-    memset (ch, '\0', FEN_LEN);
+    char *ch = fn;
+    memset (ch, '\0', FEN_LEN + 1);
 
 #undef set_next
 
@@ -1702,13 +2022,13 @@ bool   Position::fen (const char *fn, bool c960, bool full) const
         {
             if (can_castle (WHITE))
             {
-                if (can_castle (CR_W_K)) set_next (to_char (_file (_castle_rook[Castling<WHITE, CS_K>::Right]), false));
-                if (can_castle (CR_W_Q)) set_next (to_char (_file (_castle_rook[Castling<WHITE, CS_Q>::Right]), false));
+                if (can_castle (CR_W_K)) set_next (to_char (_file (castle_rook (Castling<WHITE, CS_K>::Right)), false));
+                if (can_castle (CR_W_Q)) set_next (to_char (_file (castle_rook (Castling<WHITE, CS_Q>::Right)), false));
             }
             if (can_castle (BLACK))
             {
-                if (can_castle (CR_B_K)) set_next (to_char (_file (_castle_rook[Castling<BLACK, CS_K>::Right]), true));
-                if (can_castle (CR_B_Q)) set_next (to_char (_file (_castle_rook[Castling<BLACK, CS_Q>::Right]), true));
+                if (can_castle (CR_B_K)) set_next (to_char (_file (castle_rook (Castling<BLACK, CS_K>::Right)), true));
+                if (can_castle (CR_B_Q)) set_next (to_char (_file (castle_rook (Castling<BLACK, CS_Q>::Right)), true));
             }
         }
         else
@@ -1744,9 +2064,8 @@ bool   Position::fen (const char *fn, bool c960, bool full) const
     if (full)
     {
         set_next (' ');
-        i32 write = sprintf (ch, "%u %u", _si->clock50, game_move ());
-            //_snprintf (ch, FEN_LEN - (ch - fn) - 1, "%u %u", _si->clock50, game_move ());
-            //_snprintf_s (ch, FEN_LEN - (ch - fn) - 1, 8, "%u %u", _si->clock50, game_move ());
+        i32 write = snprintf (ch, FEN_LEN + 1 - (ch - fn), "%u %u", u32 (_si->clock50), u32 (game_move ()));
+        if (write < 0 || write >= FEN_LEN + 1 - (ch - fn)) return false;
 
         ch += write;
     }
@@ -1756,7 +2075,6 @@ bool   Position::fen (const char *fn, bool c960, bool full) const
 
     return true;
 }
-#endif
 string Position::fen (bool                 c960, bool full) const
 {
     ostringstream oss;
@@ -1788,13 +2106,13 @@ string Position::fen (bool                 c960, bool full) const
         {
             if (can_castle (WHITE))
             {
-                if (can_castle (CR_W_K)) oss << to_char (_file (_castle_rook[Castling<WHITE, CS_K>::Right]), false);
-                if (can_castle (CR_W_Q)) oss << to_char (_file (_castle_rook[Castling<WHITE, CS_Q>::Right]), false);
+                if (can_castle (CR_W_K)) oss << to_char (_file (castle_rook (Castling<WHITE, CS_K>::Right)), false);
+                if (can_castle (CR_W_Q)) oss << to_char (_file (castle_rook (Castling<WHITE, CS_Q>::Right)), false);
             }
             if (can_castle (BLACK))
             {
-                if (can_castle (CR_B_K)) oss << to_char (_file (_castle_rook[Castling<BLACK, CS_K>::Right]), true);
-                if (can_castle (CR_B_Q)) oss << to_char (_file (_castle_rook[Castling<BLACK, CS_Q>::Right]), true);
+                if (can_castle (CR_B_K)) oss << to_char (_file (castle_rook (Castling<BLACK, CS_K>::Right)), true);
+                if (can_castle (CR_B_Q)) oss << to_char (_file (castle_rook (Castling<BLACK, CS_Q>::Right)), true);
             }
         }
         else
@@ -1823,6 +2141,35 @@ string Position::fen (bool                 c960, bool full) const
     return oss.str ();
 }
 
+// pack() packs the position into its compact binary form
+void Position::pack (PackedPosition &pp) const
+{
+    memset (&pp, 0, sizeof (pp));
+
+    pp.occupied = _types_bb[NONE];
+    u08 idx = 0;
+    Bitboard occ = _types_bb[NONE];
+    while (occ != U64 (0))
+    {
+        Square s = pop_lsq (occ);
+        pp.pieces[idx / 2] |= u08 (_board[s]) << (4 * (idx % 2));
+        ++idx;
+    }
+
+    pp.active     = u08 (_active);
+    pp.en_passant = u08 (_si->en_passant_sq);
+    for (u08 i = 0; i < 4; ++i)
+    {
+        CRight cr = CRight (1 << i);
+        if (can_castle (cr))
+        {
+            pp.castles |= u16 (0x8 | u08 (_file (castle_rook (cr)))) << (4 * i);
+        }
+    }
+    pp.clock50    = u08 (_si->clock50);
+    pp.game_move  = game_move ();
+}
+
 // string() returns an ASCII representation of the position to be
 // printed to the standard output
 Position::operator string () const
@@ -1920,181 +2267,139 @@ Position::operator string () const
 // 6) Fullmove number. The number of the full move.
 //    It starts at 1, and is incremented after Black's move.
 
-#ifndef NDEBUG
 #undef SKIP_WHITESPACE
-#define SKIP_WHITESPACE()  while (isspace (u08 (*fen))) ++fen
+#define SKIP_WHITESPACE()  while (*fen == ' ' || *fen == '\t') ++fen
 
+// parse() sets the fen (or the first four fields of an epd) on the position.
+// It reads the characters straight from the buffer, with no stream and no allocation,
+// and stops at the end of the string, of the line or at the first epd operation.
 bool Position::parse (Position &pos, const   char *fen, Thread *thread, bool c960, bool full)
 {
-    if (!fen)   return false;
+    if (!fen || !*fen) return false;
 
     pos.clear ();
 
     char ch;
 
-#undef get_next
-
-#define get_next()  ch = *fen++
-
-    // Piece placement on Board
-    for (Rank r = R_8; r >= R_1; --r)
+    // 1. Piece placement on Board
+    // Track the file within each rank, so that a rank running past file H,
+    // a rank ending before it or a board without exactly 8 ranks is rejected.
+    i32 f = F_A
+      , r = R_8;
+    while ((ch = *fen) != '\0' && ch != ' ' && ch != '\t' && ch != '\n' && ch != '\r')
     {
-        File f = F_A;
-        while (f <= F_H)
+        ++fen;
+        if      ('1' <= ch && ch <= '8')
         {
-            Square s = (f | r);
-            get_next ();
-            if (!ch) return false;
-
-            if      (isdigit (ch))
-            {
-                // empty square(s)
-                if ('1' > ch || ch > '8') return false;
-
-                i08 empty_count = (ch - '0');
-                f += empty_count;
-
-                if (f > F_NO) return false;
-                //while (empty_count-- > 0) place_piece (s++, EMPTY);
-            }
-            else if (isalpha (ch))
-            {
-                size_t idx = PieceChar.find (ch);
-                if (idx != string::npos)
-                {
-                    Piece p = Piece (idx);
-                    if (EMPTY == p) return false;
-                    pos.place_piece (s, p);   // put the piece on board
-                }
-                ++f;
-            }
-            else
-            {
-                return false;
-            }
+            f += ch - '0'; // Advance the given number of files
+            if (f > F_NO) return false;
         }
-        if (R_1 < r)
+        else if (ch == '/')
         {
-            get_next ();
-            if ('/' != ch) return false;
+            if (f != F_NO || r == R_1) return false;
+            f = F_A;
+            --r;
         }
         else
         {
-            for (Color c = WHITE; c <= BLACK; ++c)
-            {
-                if (1 != pos.count<KING> (c)) return false;
-            }
+            size_t idx = PieceChar.find (ch);
+            if (idx == string::npos || f >= F_NO) return false;
+            Square s = File (f) | Rank (r);
+            if (!pos.empty (s)) return false;
+            Piece p = Piece (idx);
+            pos.place_piece (s, color (p), ptype (p));
+            ++f;
         }
     }
+    if (f != F_NO || r != R_1) return false;
+    if (pos._piece_count[WHITE][KING] != 1 || pos._piece_count[BLACK][KING] != 1) return false;
 
+    // 2. Active color
     SKIP_WHITESPACE ();
-    // Active color
-    get_next ();
-    pos._active = Color (ColorChar.find (ch));
+    ch = *fen;
+    if (ch != 'w' && ch != 'b') return false;
+    ++fen;
+    pos._active = ('w' == ch) ? WHITE : BLACK;
 
-    SKIP_WHITESPACE ();
-    // Castling rights availability
+    // 3. Castling rights availability
+    File rooks[CLR_NO][CS_NO] = { { F_NO, F_NO }, { F_NO, F_NO } };
     // Compatible with 3 standards:
     // 1-Normal FEN standard,
     // 2-Shredder-FEN that uses the letters of the columns on which the rooks began the game instead of KQkq
     // 3-X-FEN standard that, in case of Chess960, if an inner rook is associated with the castling right, the castling
     // tag is replaced by the file letter of the involved rook, as for the Shredder-FEN.
-    get_next ();
-    if ('-' != ch)
+    SKIP_WHITESPACE ();
+    while ((ch = *fen) != '\0' && ch != ' ' && ch != '\t' && ch != '\n' && ch != '\r')
     {
-        if (c960)
+        ++fen;
+        Color c = ('A' <= ch && ch <= 'Z') ? WHITE : BLACK;
+        char sym = char (ch | 0x20); // lower case
+        Square rook;
+        if      (sym == 'k')
         {
-            do
-            {
-                Square rook;
-                Color c = isupper (ch) ? WHITE : BLACK;
-                char sym = tolower (ch);
-                if ('a' <= sym && sym <= 'h')
-                {
-                    rook = (to_file (sym) | rel_rank (c, R_1));
-                    if (ROOK != ptype (pos[rook])) return false;
-                    pos.set_castle (c, rook);
-                }
-                else
-                {
-                    return false;
-                }
-
-                get_next ();
-            }
-            while (ch && !isspace (ch));
+            rook = rel_sq (c, SQ_H1);
+            while ((rel_sq (c, SQ_A1) < rook) && (ROOK != ptype (pos[rook]))) --rook;
+        }
+        else if (sym == 'q')
+        {
+            rook = rel_sq (c, SQ_A1);
+            while ((rel_sq (c, SQ_H1) > rook) && (ROOK != ptype (pos[rook]))) ++rook;
+        }
+        else if (c960 && 'a' <= sym && sym <= 'h')
+        {
+            rook = (to_file (sym) | rel_rank (c, R_1));
         }
         else
         {
-            do
-            {
-                Square rook;
-                Color c = isupper (ch) ? WHITE : BLACK;
-                switch (toupper (ch))
-                {
-                case 'K':
-                    rook = rel_sq (c, SQ_H1);
-                    while ((rel_sq (c, SQ_A1) <= rook) && (ROOK != ptype (pos[rook]))) --rook;
-                    break;
-                case 'Q':
-                    rook = rel_sq (c, SQ_A1);
-                    while ((rel_sq (c, SQ_H1) >= rook) && (ROOK != ptype (pos[rook]))) ++rook;
-                    break;
-                default: return false;
-                }
-                if (ROOK != ptype (pos[rook])) return false;
-                pos.set_castle (c, rook);
-
-                get_next ();
-            }
-            while (ch && !isspace (ch));
+            continue;
         }
+        if ((c | ROOK) == pos[rook]) pos.set_castle (c, rook, rooks);
     }
+    pos._castle = shared_castle (pos, rooks);
 
+    // 4. En-passant square. Ignore if no pawn capture is possible
     SKIP_WHITESPACE ();
-    // En-passant square
-    get_next ();
-    if ('-' != ch)
+    char col = *fen;
+    if ('a' <= col && col <= 'h')
     {
-        char col = tolower (ch);
-        if (!isalpha (col)) return false;
-        if ('a' > col || col > 'h') return false;
-
-        char row = get_next ();
-
-        if (!isdigit (row)) return false;
-        if (!( (WHITE == pos._active && '6' != row)
-            || (BLACK == pos._active && '3' != row)))
+        char row = *(++fen);
+        if (row != '\0') ++fen;
+        if (row == (WHITE == pos._active ? '6' : '3'))
         {
-            Square ep_sq  = to_square (col, row);
+            Square ep_sq = to_square (col, row);
             if (pos.can_en_passant (ep_sq))
             {
                 pos._si->en_passant_sq = ep_sq;
             }
         }
     }
-    // 50-move clock and game-move count
+    else if ('-' == col)
+    {
+        ++fen;
+    }
+
+    // 5-6. 50-move clock and game-move count, missing in an epd
     i32 clk50 = 0, g_move = 1;
-    get_next ();
-    if (full && ch)
+    if (full)
     {
-        i32 n = 0;
-        i32 read = sscanf (--fen, " %d %d%n", &clk50, &g_move, &n);
-        if (read != 2) return false;
-        fen += n;
+        SKIP_WHITESPACE ();
+        if ('0' <= *fen && *fen <= '9')
+        {
+            clk50 = 0;
+            while ('0' <= *fen && *fen <= '9' && clk50 <= 100) clk50 = 10 * clk50 + (*fen++ - '0');
+            SKIP_WHITESPACE ();
+            g_move = 0;
+            while ('0' <= *fen && *fen <= '9' && g_move < 100000) g_move = 10 * g_move + (*fen++ - '0');
+        }
         // Rule 50 draw case
         if (100 < clk50) return false;
         if (0 >= g_move) g_move = 1;
-        //get_next ();
-        //if (ch) return false; // NOTE: extra characters
     }
 
-#undef get_next
-
     // Convert from game_move starting from 1 to game_ply starting from 0,
     // handle also common incorrect FEN with game_move = 0.
     pos._si->clock50 = (SQ_NO != pos._si->en_passant_sq) ? 0 : clk50;
-    pos._game_ply = max<i16> (2 * (g_move - 1), 0) + (BLACK == pos._active);
+    pos._game_ply = max (2 * (g_move - 1), 0) + (BLACK == pos._active);
 
     pos._si->matl_key = Zob.compute_matl_key (pos);
     pos._si->pawn_key = Zob.compute_pawn_key (pos);
@@ -2102,6 +2407,9 @@ bool Position::parse (Position &pos, const   char *fen, Thread *thread, bool c96
     pos._si->psq_score = pos.compute_psq_score ();
     pos._si->non_pawn_matl[WHITE] = pos.compute_non_pawn_material (WHITE);
     pos._si->non_pawn_matl[BLACK] = pos.compute_non_pawn_material (BLACK);
+#ifdef ATTACKMAP
+    pos.update_attacks (pos._types_bb[NONE]);
+#endif
     pos._si->checkers = pos.checkers (pos._active);
     pos._chess960     = c960;
     pos._game_nodes   = 0;
@@ -2110,128 +2418,66 @@ bool Position::parse (Position &pos, const   char *fen, Thread *thread, bool c96
     return true;
 }
 #undef SKIP_WHITESPACE
-#endif
 
 bool Position::parse (Position &pos, const string &fen, Thread *thread, bool c960, bool full)
 {
-    if (fen.empty ()) return false;
-
-    pos.clear ();
+    return parse (pos, fen.c_str (), thread, c960, full);
+}
 
-    istringstream iss (fen);
-    char ch;
+// parse() sets the packed position on the position
+bool Position::parse (Position &pos, const PackedPosition &pp, Thread *thread, bool c960)
+{
+    if (pop_count<FULL> (pp.occupied) > 32) return false;
 
-    iss >> noskipws;
+    pos.clear ();
 
     // 1. Piece placement on Board
-    size_t idx;
-    Square s = SQ_A8;
-    while ((iss >> ch) && !isspace (ch))
+    u08 idx = 0;
+    Bitboard occ = pp.occupied;
+    while (occ != U64 (0))
     {
-        if (isdigit (ch))
-        {
-            s += Delta (ch - '0'); // Advance the given number of files
-        }
-        else if (isalpha (ch) && (idx = PieceChar.find (ch)) != string::npos)
-        {
-            Piece p = Piece (idx);
-            pos.place_piece (s, color (p), ptype (p));
-            ++s;
-        }
-        else if (ch == '/')
-        {
-            s += DEL_SS;
-        }
-        else
-        {
-            return false;
-        }
+        Square s = pop_lsq (occ);
+        Piece  p = Piece ((pp.pieces[idx / 2] >> (4 * (idx % 2))) & 0xF);
+        if (!_ok (p) || pos._piece_count[color (p)][ptype (p)] >= 16) return false;
+        pos.place_piece (s, color (p), ptype (p));
+        ++idx;
     }
+    if (pos._piece_count[WHITE][KING] != 1 || pos._piece_count[BLACK][KING] != 1) return false;
 
     // 2. Active color
-    iss >> ch;
-    pos._active = Color (ColorChar.find (ch));
+    if (pp.active > BLACK) return false;
+    pos._active = Color (pp.active);
 
     // 3. Castling rights availability
-    // Compatible with 3 standards:
-    // 1-Normal FEN standard,
-    // 2-Shredder-FEN that uses the letters of the columns on which the rooks began the game instead of KQkq
-    // 3-X-FEN standard that, in case of Chess960, if an inner rook is associated with the castling right, the castling
-    // tag is replaced by the file letter of the involved rook, as for the Shredder-FEN.
-    iss >> ch;
-    if (c960)
-    {
-        while ((iss >> ch) && !isspace (ch))
-        {
-            Square rook;
-            Color c = isupper (ch) ? WHITE : BLACK;
-            char sym = tolower (ch);
-            if ('a' <= sym && sym <= 'h')
-            {
-                rook = (to_file (sym) | rel_rank (c, R_1));
-                //if (ROOK != ptype (pos[rook])) return false;
-                pos.set_castle (c, rook);
-            }
-            else
-            {
-                continue;
-            }
-        }
-    }
-    else
+    File rooks[CLR_NO][CS_NO] = { { F_NO, F_NO }, { F_NO, F_NO } };
+    for (u08 i = 0; i < 4; ++i)
     {
-        while ((iss >> ch) && !isspace (ch))
+        u08 right = (pp.castles >> (4 * i)) & 0xF;
+        if (right & 0x8)
         {
-            Square rook;
-            Color c = isupper (ch) ? WHITE : BLACK;
-            switch (toupper (ch))
-            {
-            case 'K':
-                rook = rel_sq (c, SQ_H1);
-                while ((rel_sq (c, SQ_A1) <= rook) && (ROOK != ptype (pos[rook]))) --rook;
-                break;
-            case 'Q':
-                rook = rel_sq (c, SQ_A1);
-                while ((rel_sq (c, SQ_H1) >= rook) && (ROOK != ptype (pos[rook]))) ++rook;
-                break;
-            default:
-                continue;
-            }
-
-            //if (ROOK != ptype (pos[rook])) return false;
-            pos.set_castle (c, rook);
+            Color c = (i < 2) ? WHITE : BLACK;
+            Square rook = (File (right & 0x7) | rel_rank (c, R_1));
+            if ((c | ROOK) != pos[rook]) return false;
+            pos.set_castle (c, rook, rooks);
         }
     }
+    pos._castle = shared_castle (pos, rooks);
 
     // 4. En-passant square. Ignore if no pawn capture is possible
-    char col, row;
-    if (   ((iss >> col) && (col >= 'a' && col <= 'h'))
-        && ((iss >> row) && (row == '3' || row == '6')))
+    Square ep_sq = Square (pp.en_passant);
+    if (   SQ_NO != ep_sq
+        && _ok (ep_sq)
+        && R_6 == rel_rank (pos._active, ep_sq)
+        && pos.can_en_passant (ep_sq))
     {
-        if (!( (WHITE == pos._active && '6' != row)
-            || (BLACK == pos._active && '3' != row)))
-        {
-            Square ep_sq = to_square (col, row);
-            if (pos.can_en_passant (ep_sq))
-            {
-                pos._si->en_passant_sq = ep_sq;
-            }
-        }
+        pos._si->en_passant_sq = ep_sq;
     }
 
     // 5-6. 50-move clock and game-move count
-    i32 clk50 = 0, g_move = 1;
-    if (full)
-    {
-        iss >> skipws >> clk50 >> g_move;
-        // Rule 50 draw case
-        if (100 < clk50) return false;
-        if (0 >= g_move) g_move = 1;
-    }
+    if (100 < pp.clock50) return false;
+    i32 g_move = max<i32> (pp.game_move, 1);
 
-    // Convert from game_move starting from 1 to game_ply starting from 0,
-    // handle also common incorrect FEN with game_move = 0.
-    pos._si->clock50 = (SQ_NO != pos._si->en_passant_sq) ? 0 : clk50;
+    pos._si->clock50 = (SQ_NO != pos._si->en_passant_sq) ? 0 : pp.clock50;
     pos._game_ply = max (2 * (g_move - 1), 0) + (BLACK == pos._active);
 
     pos._si->matl_key = Zob.compute_matl_key (pos);
@@ -2240,6 +2486,9 @@ bool Position::parse (Position &pos, const string &fen, Thread *thread, bool c96
     pos._si->psq_score = pos.compute_psq_score ();
     pos._si->non_pawn_matl[WHITE] = pos.compute_non_pawn_material (WHITE);
     pos._si->non_pawn_matl[BLACK] = pos.compute_non_pawn_material (BLACK);
+#ifdef ATTACKMAP
+    pos.update_attacks (pos._types_bb[NONE]);
+#endif
     pos._si->checkers = pos.checkers (pos._active);
     pos._chess960     = c960;
     pos._game_nodes   = 0;
@@ -6,12 +6,14 @@
 #define _POSITION_H_INC_
 
 #include <algorithm>
+#include <cstddef>
 #include <memory>
-#include <stack>
+#include <vector>
 
 #include "BitBoard.h"
 #include "BitScan.h"
 #include "Zobrist.h"
+#include "Network.h"
 
 class Position;
 
@@ -22,18 +24,15 @@ namespace Threads {
 // FORSYTH-EDWARDS NOTATION (FEN) is a standard notation for describing a particular board position of a chess game.
 // The purpose of FEN is to provide all the necessary information to restart a game from a particular position.
 
-#ifndef NDEBUG
 // 88 is the max FEN length - r1n1k1r1/1B1b1q1n/1p1p1p1p/p1p1p1p1/1P1P1P1P/P1P1P1P1/1b1B1Q1N/R1N1K1R1 w KQkq - 12 1000
+// a buffer for the FEN needs one more char for the null-terminator (FEN_LEN + 1)
 const u08 FEN_LEN     = 88;
-#endif
 
 extern const std::string FEN_N;
 extern const std::string FEN_X;
 
 // Check the validity of FEN string
-#ifndef NDEBUG
 extern bool _ok (const        char *fen, bool c960 = false, bool full = true);
-#endif
 extern bool _ok (const std::string &fen, bool c960 = false, bool full = true);
 
 // StateInfo stores information to restore Position object to its previous state when retracting a move.
@@ -77,7 +76,80 @@ public:
     StateInfo *p_si;
 };
 
-typedef std::stack<StateInfo>   StateInfoStack;
+// StateInfoStack keeps the StateInfo of the moves played on a position
+// (setup moves of the game, moves of a pv ...).
+// StateInfo are linked through 'p_si' so they must never move once pushed,
+// that is why the storage is an arena of fixed size blocks instead of a container
+// which reallocates. The first block is allocated on the first push, so a whole game
+// usually lives in one contiguous block and the 'p_si' chain walked by draw() and
+// repeated() stays cache-friendly, while a stack which is never pushed costs nothing.
+class StateInfoStack
+{
+
+private:
+
+    std::vector<StateInfo*> _blocks;
+    u32 _size;
+
+    StateInfo& at (u32 i) const { return _blocks[i / BLOCK_SIZE][i % BLOCK_SIZE]; }
+
+    // Non-copyable, the 'p_si' of the copies would still point to the source stack
+    StateInfoStack (const StateInfoStack&);
+    StateInfoStack& operator= (const StateInfoStack&);
+
+public:
+
+    static const u16 BLOCK_SIZE = 1024;
+
+    StateInfoStack ()
+        : _size (0)
+    {}
+   ~StateInfoStack ()
+    {
+        for (u32 b = 0; b < _blocks.size (); ++b)
+        {
+            delete[] _blocks[b];
+        }
+    }
+
+    bool empty () const { return 0 == _size; }
+    u32  size  () const { return _size; }
+
+    StateInfo&       top ()       { ASSERT (_size != 0); return at (_size - 1); }
+    const StateInfo& top () const { ASSERT (_size != 0); return at (_size - 1); }
+
+    void push (const StateInfo &si)
+    {
+        if (_size == _blocks.size () * BLOCK_SIZE)
+        {
+            _blocks.push_back (new StateInfo[BLOCK_SIZE]);
+        }
+        at (_size++) = si;
+    }
+    void pop () { ASSERT (_size != 0); --_size; }
+
+};
+
+// RepetitionTable counts the keys of the positions on the path of a thread,
+// added by do_move() and removed by undo_move(). Different keys may share a slot,
+// so it can only tell that a position is not repeated: draw() walks the 'p_si' chain
+// only when the key of the position is counted more than once.
+// The table of a thread also holds the positions it searches as a slave at the
+// splitpoints and the ones left by the setup moves, which only make more walks.
+struct RepetitionTable
+{
+public:
+    static const u16 SIZE = 4096;
+
+    u16 counts[SIZE];
+
+    void clear () { std::fill (counts, counts + SIZE, 0); }
+
+    void add    (Key key) { ++counts[key & (SIZE - 1)]; }
+    void remove (Key key) { --counts[key & (SIZE - 1)]; }
+
+    bool repeatable (Key key) const { return counts[key & (SIZE - 1)] > 1; }
+};
 
 // CheckInfo struct is initialized at c'tor time.
 // CheckInfo stores critical information used to detect if a move gives check.
@@ -97,6 +169,44 @@ public:
     explicit CheckInfo (const Position &pos);
 };
 
+// CastleInfo stores the castling data, which depends only on the setup of the position:
+//  - Castling rights lost when moving from or to the square.
+//  - Castling rooks.
+//  - Squares which must be empty to castle.
+// The CastleInfos of all the setups are built at initialization and never modified after,
+// so all the positions with the same setup share one CastleInfo by pointer, and copying
+// a position (splitpoints) does not copy it.
+struct CastleInfo
+{
+public:
+    CRight   castle_mask[SQ_NO];
+    Square   castle_rook[CR_ALL];
+    Bitboard castle_path[CR_ALL];
+
+    CastleInfo ();
+};
+
+// PackedPosition is a compact binary form of a position, 32 bytes.
+// Used to store and exchange large sets of positions without FEN parsing.
+//  - Occupied squares bitboard.
+//  - Piece of each occupied square in square order, 4 bits each (at most 32 pieces).
+//  - Side on move.
+//  - En-passant square (SQ_NO if none).
+//  - Castling rights, 4 bits each in CRight order: bit 3 is set if the right
+//    is available, bits 0-2 are the file of the castling rook (for Chess960).
+//  - 50-move clock and game-move count.
+struct PackedPosition
+{
+    u64 occupied;
+    u08 pieces[16];
+    u08 active;
+    u08 en_passant;
+    u16 castles;
+    u08 clock50;
+    u08 pad;
+    u16 game_move;
+};
+
 // The position data structure. A position consists of the following data:
 //
 // Board consits of data about piece placement
@@ -107,15 +217,19 @@ public:
 //  - List of squares for the pieces.
 //  - Count of the pieces.
 //  - ----------x-----------
-//  - Color of side on move.
-//  - Ply of the game.
 //  - StateInfo object for the base status.
 //  - StateInfo pointer for the current status.
-//  - Information about the castling rights for both sides.
-//  - The initial files of the kings and both pairs of rooks. This is
-//    used to implement the Chess960 castling rules.
-//  - Nodes visited during search.
+//  - Pointer to the shared castling data (CastleInfo), used to implement
+//    the castling rules (also Chess960).
+//  - Color of side on move.
+//  - Ply of the game.
 //  - Chess 960 info
+//  - Nodes visited during search.
+//  - ----------x-----------
+//  - Attack maps (if compiled in).
+//  - First layer of the network.
+// Copies (splitpoints) copy the members in this order, and stop before the network
+// layer when the network is not active, so hot members go first and the big ones last.
 class Position
 {
 
@@ -133,9 +247,7 @@ private:
     StateInfo  _sb; // Object for base status information
     StateInfo *_si; // Pointer for current status information
 
-    CRight   _castle_mask[SQ_NO];
-    Square   _castle_rook[CR_ALL];
-    Bitboard _castle_path[CR_ALL];
+    const CastleInfo *_castle;
 
     // Side on move
     // "w" - WHITE
@@ -149,9 +261,20 @@ private:
 
     Threads::Thread *_thread;
 
+#ifdef ATTACKMAP
+    // Incrementally maintained attack maps
+    Bitboard _attacks  [SQ_NO]; // Squares attacked by the piece on the square
+    Bitboard _attackers[SQ_NO]; // Pieces (of both color) attacking the square
+#endif
+
+    // First layer of the network, updated by the piece deltas when the network is active
+    // and refreshed when stale (mutable as it is refreshed from the const evaluation).
+    // Must stay the last member.
+    mutable Network::Accumulator _accumulator;
+
     // ------------------------
 
-    void set_castle (Color c, Square org_rook);
+    void set_castle (Color c, Square org_rook, File rooks[CLR_NO][CS_NO]);
 
     bool can_en_passant (Square ep_sq) const;
     bool can_en_passant (File   ep_f ) const { return can_en_passant (ep_f | rel_rank (_active, R_6)); }
@@ -161,6 +284,11 @@ private:
     template<bool DO>
     void do_castling (Square org_king, Square &dst_king, Square &org_rook, Square &dst_rook);
 
+#ifdef ATTACKMAP
+    Bitboard compute_attacks (Square s) const;
+    void update_attacks (Bitboard changed);
+#endif
+
     template<PieceT PT>
     PieceT least_valuable_attacker (Square dst, Bitboard stm_attackers, Bitboard &occupied, Bitboard &attackers) const;
 
@@ -172,12 +300,10 @@ public:
 
     Position () { clear (); }
 
-#ifndef NDEBUG
     Position (const char        *f, Threads::Thread *th = NULL, bool c960 = false, bool full = true)
     {
         if (!setup (f, th, c960, full)) clear ();
     }
-#endif
     Position (const std::string &f, Threads::Thread *th = NULL, bool c960 = false, bool full = true)
     {
         if (!setup (f, th, c960, full)) clear ();
@@ -190,6 +316,9 @@ public:
 
     Position& operator= (const Position &pos);
 
+    // Bytes copied by a copy of the position
+    static u32 copy_size ();
+
     Piece    operator[] (Square s)      const;
     Bitboard operator[] (Color  c)      const;
     Bitboard operator[] (PieceT pt)     const;
@@ -241,6 +370,8 @@ public:
 
     Score psq_score ()      const;
 
+    const Network::Accumulator& accumulator () const;
+
     CRight can_castle   (CRight cr) const;
     CRight can_castle   (Color   c) const;
 
@@ -253,6 +384,9 @@ public:
     bool    chess960  () const;
     bool    draw      () const;
     bool    repeated  () const;
+    bool    upcoming_repetition (i32 ply) const;
+
+    void    count_path (bool add) const;
 
     u64  game_nodes ()   const;
     void game_nodes (u64 nodes);
@@ -272,6 +406,13 @@ public:
     Bitboard attackers_to (Square s, Bitboard occ) const;
     Bitboard attackers_to (Square s) const;
 
+#ifdef ATTACKMAP
+    // Attacks of the piece on the square, from the attack maps
+    Bitboard attacks_from (Square s) const;
+    // Attackers (of both color) to the square, from the attack maps
+    Bitboard attackers_at (Square s) const;
+#endif
+
     Bitboard checkers    (Color c)   const;
     Bitboard pinneds     (Color c)   const;
     Bitboard discoverers (Color c)   const;
@@ -298,10 +439,11 @@ public:
     void remove_piece (Square s);
     void   move_piece (Square s1, Square s2);
 
-#ifndef NDEBUG
     bool setup (const        char *f, Threads::Thread *th = NULL, bool c960 = false, bool full = true);
-#endif
     bool setup (const std::string &f, Threads::Thread *th = NULL, bool c960 = false, bool full = true);
+    bool setup (const PackedPosition &pp, Threads::Thread *th = NULL, bool c960 = false);
+
+    void pack (PackedPosition &pp) const;
 
     void flip ();
 
@@ -313,22 +455,20 @@ public:
     void do_move (Move m, StateInfo &n_si);
     void do_move (std::string &can, StateInfo &n_si);
     void undo_move ();
+    void copy_move (Move m, Position &pos, StateInfo &n_si, const CheckInfo *ci) const;
     void do_null_move (StateInfo &n_si);
     void undo_null_move ();
 
-#ifndef NDEBUG
-    bool        fen (const char *f, bool c960, bool full = true) const;
-    bool        fen (const char *f) const { return fen (f, false);  }
-#endif
+    bool        fen (char *f, bool c960, bool full = true) const;
+    bool        fen (char *f) const { return fen (f, false);  }
     std::string fen (bool                c960, bool full = true) const;
     std::string fen (             ) const { return fen (false);     }
     
     operator std::string () const;
 
-#ifndef NDEBUG
     static bool parse (Position &pos, const        char *fen, Threads::Thread *thread = NULL, bool c960 = false, bool full = true);
-#endif
     static bool parse (Position &pos, const std::string &fen, Threads::Thread *thread = NULL, bool c960 = false, bool full = true);
+    static bool parse (Position &pos, const PackedPosition &pp, Threads::Thread *thread = NULL, bool c960 = false);
 
     template<class charT, class Traits>
     friend std::basic_ostream<charT, Traits>&
@@ -410,11 +550,23 @@ inline Key    Position::pawn_key      () const { return _si->pawn_key; }
 inline Key    Position::posi_key      () const { return _si->posi_key; }
 inline Key    Position::posi_key_exclusion () const { return _si->posi_key ^ Zobrist::Exclusion; }
 inline Score  Position::psq_score     () const { return _si->psq_score; }
+inline const Network::Accumulator& Position::accumulator () const
+{
+    if (_accumulator.generation != Network::Generation)
+    {
+        Network::refresh (_accumulator, *this);
+    }
+    return _accumulator;
+}
 inline Value  Position::non_pawn_material (Color c) const { return _si->non_pawn_matl[c]; }
 inline CRight Position::can_castle   (CRight cr) const { return _si->castle_rights & cr; }
 inline CRight Position::can_castle   (Color   c) const { return _si->castle_rights & mk_castle_right (c); }
-inline Square Position::castle_rook  (CRight cr) const { return _castle_rook[cr]; }
-inline bool Position::castle_impeded (CRight cr) const { return _castle_path[cr] & _types_bb[NONE]; }
+inline u32 Position::copy_size ()
+{
+    return Network::Active ? sizeof (Position) : offsetof (Position, _accumulator);
+}
+inline Square Position::castle_rook  (CRight cr) const { return _castle->castle_rook[cr]; }
+inline bool Position::castle_impeded (CRight cr) const { return _castle->castle_path[cr] & _types_bb[NONE]; }
 // Color of the side on move
 inline Color Position::active   () const { return _active; }
 // game_ply starts at 0, and is incremented after every move.
@@ -456,10 +608,19 @@ inline Bitboard Position::attackers_to (Square s) const
 {
     return attackers_to (s, _types_bb[NONE]);
 }
+#ifdef ATTACKMAP
+inline Bitboard Position::attacks_from (Square s) const { return _attacks  [s]; }
+inline Bitboard Position::attackers_at (Square s) const { return _attackers[s]; }
+#endif
+
 // Checkers are enemy pieces that give the direct Check to friend King of color 'c'
 inline Bitboard Position::checkers (Color c) const
 {
+#ifdef ATTACKMAP
+    return _attackers[_piece_list[c][KING][0]] & _color_bb[~c];
+#else
     return attackers_to (_piece_list[c][KING][0], _types_bb[NONE]) & _color_bb[~c];
+#endif
 }
 // Pinners => Only bishops, rooks, queens...  kings, knights, and pawns cannot pin.
 // Pinneds => All except king, king must be immediately removed from check under all circumstances.
@@ -543,6 +704,8 @@ inline void  Position:: place_piece (Square s, Color c, PieceT pt)
     // Update piece list, put piece at [s] index
     _index[s]  = _piece_count[c][pt]++;
     _piece_list[c][pt][_index[s]] = s;
+
+    if (Network::Active) Network::add_piece (_accumulator, c, pt, s);
 }
 inline void  Position:: place_piece (Square s, Piece p)
 {
@@ -578,6 +741,8 @@ inline void  Position::remove_piece (Square s)
     }
     _index[s] = -1;
     _piece_list[c][pt][_piece_count[c][pt]]   = SQ_NO;
+
+    if (Network::Active) Network::remove_piece (_accumulator, c, pt, s);
 }
 inline void  Position::  move_piece (Square s1, Square s2)
 {
@@ -601,6 +766,8 @@ inline void  Position::  move_piece (Square s1, Square s2)
     _index[s2] = _index[s1];
     _index[s1] = -1;
     _piece_list[c][pt][_index[s2]] = s2;
+
+    if (Network::Active) Network::move_piece (_accumulator, c, pt, s1, s2);
 }
 // Position::do_castling() is a helper used to do/undo a castling move.
 // This is a bit tricky, especially in Chess960.
@@ -0,0 +1,199 @@
+#include "PositionStream.h"
+
+#include <cstring>
+
+using namespace std;
+using namespace Threads;
+
+FenReader::FenReader (const string &fn)
+    : _ifs (fn.c_str (), ios_base::in | ios_base::binary)
+    , _buffer (BUFFER_SIZE + 1)
+    , _eof (false)
+    , _lines (0)
+    , _skipped (0)
+{
+    _cur  = _end = &_buffer[0];
+    _line = NULL;
+}
+
+// fill() moves the part of the line left at the end of the buffer to its start
+// and reads the next block of the file after it.
+bool FenReader::fill ()
+{
+    size_t rest = _end - _cur;
+    if (_cur != &_buffer[0])
+    {
+        memmove (&_buffer[0], _cur, rest);
+        _cur = &_buffer[0];
+        _end = _cur + rest;
+    }
+
+    size_t space = BUFFER_SIZE - rest;
+    if (_eof || space == 0) return false;
+
+    _ifs.read (_end, space);
+    size_t count = size_t (_ifs.gcount ());
+    if (count < space) _eof = true;
+    _end += count;
+    return count != 0;
+}
+
+// read_line() returns the next line of the file (null-terminated, in the buffer),
+// NULL at the end of the file. A line longer than the buffer is cut.
+const char* FenReader::read_line ()
+{
+    if (!_ifs.is_open ()) return NULL;
+
+    char *eol;
+    while ((eol = (char *) memchr (_cur, '\n', _end - _cur)) == NULL)
+    {
+        if (!fill ())
+        {
+            if (_cur == _end) return NULL;
+            // Last line without end of line
+            eol = _end;
+            break;
+        }
+    }
+
+    _line = _cur;
+    _cur  = (eol != _end) ? eol + 1 : eol;
+    *eol  = '\0';
+    if (eol != _line && *(eol - 1) == '\r') *(eol - 1) = '\0';
+    ++_lines;
+    return _line;
+}
+
+// read() sets the position of the next valid line of the file,
+// the empty lines are ignored and the invalid ones skipped.
+bool FenReader::read (Position &pos, Thread *th, bool c960, bool full)
+{
+    while (read_line () != NULL)
+    {
+        if (*_line == '\0') continue;
+        if (pos.setup (_line, th, c960, full)) return true;
+        ++_skipped;
+    }
+    return false;
+}
+
+FenWriter::FenWriter (const string &fn)
+    : _ofs (fn.c_str (), ios_base::out | ios_base::binary)
+    , _buffer (BUFFER_SIZE)
+    , _size (0)
+    , _written (0)
+    , _dropped (0)
+{}
+
+// write() writes the fen of the position in the buffer,
+// a position which has no valid fen is dropped (and counted).
+bool FenWriter::write (const Position &pos, bool c960, bool full)
+{
+    if (_size + FEN_LEN + 1 > BUFFER_SIZE) flush ();
+
+    char *fen = &_buffer[_size];
+    if (!pos.fen (fen, c960, full))
+    {
+        ++_dropped;
+        return false;
+    }
+
+    _size += u32 (strlen (fen));
+    _buffer[_size++] = '\n';
+    ++_written;
+    return true;
+}
+
+void FenWriter::flush ()
+{
+    if (_size != 0)
+    {
+        _ofs.write (&_buffer[0], _size);
+        _size = 0;
+    }
+}
+
+void FenWriter::close ()
+{
+    if (_ofs.is_open ())
+    {
+        flush ();
+        _ofs.close ();
+    }
+}
+
+PackedReader::PackedReader (const string &fn)
+    : _ifs (fn.c_str (), ios_base::in | ios_base::binary)
+    , _buffer (BUFFER_COUNT)
+    , _count (0)
+    , _index (0)
+    , _read (0)
+{}
+
+// read() gives the next packed position of the file, reading the next block if needed
+bool PackedReader::read (PackedPosition &pp)
+{
+    if (_index == _count)
+    {
+        if (!_ifs.is_open () || !_ifs.good ()) return false;
+
+        _ifs.read ((char *) &_buffer[0], streamsize (BUFFER_COUNT) * sizeof (PackedPosition));
+        _count = u32 (size_t (_ifs.gcount ()) / sizeof (PackedPosition));
+        _index = 0;
+        if (_count == 0) return false;
+    }
+
+    pp = _buffer[_index++];
+    ++_read;
+    return true;
+}
+
+// read() sets the position of the next valid packed position of the file
+bool PackedReader::read (Position &pos, Thread *th, bool c960)
+{
+    PackedPosition pp;
+    while (read (pp))
+    {
+        if (pos.setup (pp, th, c960)) return true;
+    }
+    return false;
+}
+
+PackedWriter::PackedWriter (const string &fn)
+    : _ofs (fn.c_str (), ios_base::out | ios_base::binary)
+    , _buffer (BUFFER_COUNT)
+    , _count (0)
+    , _written (0)
+{}
+
+void PackedWriter::write (const PackedPosition &pp)
+{
+    _buffer[_count++] = pp;
+    ++_written;
+    if (_count == BUFFER_COUNT) flush ();
+}
+
+void PackedWriter::write (const Position &pos)
+{
+    PackedPosition pp;
+    pos.pack (pp);
+    write (pp);
+}
+
+void PackedWriter::flush ()
+{
+    if (_count != 0)
+    {
+        _ofs.write ((const char *) &_buffer[0], streamsize (_count) * sizeof (PackedPosition));
+        _count = 0;
+    }
+}
+
+void PackedWriter::close ()
+{
+    if (_ofs.is_open ())
+    {
+        flush ();
+        _ofs.close ();
+    }
+}
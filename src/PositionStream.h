@@ -0,0 +1,149 @@
+#ifdef _MSC_VER
+#   pragma once
+#endif
+
+#ifndef _POSITION_STREAM_H_INC_
+#define _POSITION_STREAM_H_INC_
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Position.h"
+#include "noncopyable.h"
+
+// Streams of positions, to load and store large sets of positions (datasets,
+// tuning and training data) with no allocation and no formatted stream per position.
+//  - FenReader reads a text file of fen (or epd) lines in large blocks and parses
+//    each line in place.
+//  - FenWriter writes the fen of the positions through a buffer.
+//  - PackedReader and PackedWriter read and write the packed positions (32 bytes each)
+//    of a binary file through a buffer. The packed positions are stored as they are
+//    in memory, so the file is meant to be read on a platform of the same byte order.
+
+// FenReader reads the positions of a text file, one fen or epd per line
+class FenReader
+    : public std::noncopyable
+{
+
+private:
+
+    std::ifstream     _ifs;
+    std::vector<char> _buffer;
+    char *_cur
+        , *_end
+        , *_line;
+    bool  _eof;
+    u64   _lines
+        , _skipped;
+
+    bool fill ();
+
+public:
+
+    static const u32 BUFFER_SIZE = 1 << 20;
+
+    explicit FenReader (const std::string &fn);
+
+    bool is_open () const { return _ifs.is_open (); }
+
+    // Number of lines read and of lines which are not a valid position
+    u64 lines   () const { return _lines; }
+    u64 skipped () const { return _skipped; }
+
+    // The last line read (null-terminated, without end of line)
+    const char* line () const { return _line; }
+
+    const char* read_line ();
+    bool read (Position &pos, Threads::Thread *th = NULL, bool c960 = false, bool full = true);
+
+};
+
+// FenWriter writes the fen of the positions to a text file, one per line
+class FenWriter
+    : public std::noncopyable
+{
+
+private:
+
+    std::ofstream     _ofs;
+    std::vector<char> _buffer;
+    u32 _size;
+    u64 _written
+        , _dropped;
+
+public:
+
+    static const u32 BUFFER_SIZE = 1 << 20;
+
+    explicit FenWriter (const std::string &fn);
+   ~FenWriter () { close (); }
+
+    bool is_open () const { return _ofs.is_open (); }
+    // Number of positions written and of positions which have no valid fen
+    u64  written () const { return _written; }
+    u64  dropped () const { return _dropped; }
+
+    bool write (const Position &pos, bool c960 = false, bool full = true);
+    void flush ();
+    void close ();
+
+};
+
+// PackedReader reads the packed positions of a binary file
+class PackedReader
+    : public std::noncopyable
+{
+
+private:
+
+    std::ifstream _ifs;
+    std::vector<PackedPosition> _buffer;
+    u32 _count
+        , _index;
+    u64 _read;
+
+public:
+
+    static const u32 BUFFER_COUNT = 1 << 15;
+
+    explicit PackedReader (const std::string &fn);
+
+    bool is_open () const { return _ifs.is_open (); }
+    u64  read_count () const { return _read; }
+
+    bool read (PackedPosition &pp);
+    bool read (Position &pos, Threads::Thread *th = NULL, bool c960 = false);
+
+};
+
+// PackedWriter writes the packed positions to a binary file
+class PackedWriter
+    : public std::noncopyable
+{
+
+private:
+
+    std::ofstream _ofs;
+    std::vector<PackedPosition> _buffer;
+    u32 _count;
+    u64 _written;
+
+public:
+
+    static const u32 BUFFER_COUNT = 1 << 15;
+
+    explicit PackedWriter (const std::string &fn);
+   ~PackedWriter () { close (); }
+
+    bool is_open () const { return _ofs.is_open (); }
+    u64  written () const { return _written; }
+
+    void write (const PackedPosition &pp);
+    void write (const Position &pos);
+    void flush ();
+    void close ();
+
+};
+
+#endif // _POSITION_STREAM_H_INC_
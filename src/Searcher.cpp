@@ -16,6 +16,8 @@
 #include "Pawns.h"
 #include "Evaluator.h"
 #include "TB_Syzygy.h"
+#include "MateSearcher.h"
+#include "AnalysisDB.h"
 #include "Thread.h"
 #include "Notation.h"
 #include "Debugger.h"
@@ -74,6 +76,7 @@ namespace Searcher {
         Value   DrawValue[CLR_NO];
         
         double  BestMoveChanges;
+        u08     RootDepth;  // Depth of the last completed iteration
 
         u08     MultiPV
             ,   IndexPV;
@@ -278,9 +281,40 @@ namespace Searcher {
 
         };
 
+        // make_move() makes the move for the search and returns the position to go on with:
+        //  - do-undo  : the position itself, unmake_move() undoes the move on it.
+        //  - copy-make: a copy of the position on the per-ply stack of the thread with the
+        //               move made on it, the position itself is left untouched.
+        inline Position& make_move (Position &pos, Move m, StateInfo &si, const CheckInfo *ci, const Stack *ss)
+        {
+#ifdef COPYMAKE
+            ASSERT (pos.thread () != NULL);
+            Position &child = pos.thread ()->ply_positions[(ss)->ply + 1];
+            pos.copy_move (m, child, si, ci);
+            return child;
+#else
+            (void) ss;
+            pos.do_move (m, si, ci);
+            return pos;
+#endif
+        }
+
+        // unmake_move() takes back the move made by make_move(),
+        // with copy-make only the nodes visited are taken back from the copy.
+        inline void unmake_move (Position &pos, const Position &child)
+        {
+#ifdef COPYMAKE
+            pos.game_nodes (child.game_nodes ());
+            pos.thread ()->repetitions.remove (child.posi_key ());
+#else
+            (void) child;
+            pos.undo_move ();
+#endif
+        }
+
         // _perft() is our utility to verify move generation. All the leaf nodes
         // up to the given depth are generated and counted and the sum returned.
-        inline u64 _perft (Position &pos, const Depth &depth)
+        inline u64 _perft (Position &pos, const Stack *ss, const Depth &depth)
         {
             const bool leaf = (depth == 2*ONE_MOVE);
 
@@ -291,9 +325,9 @@ namespace Searcher {
             for (MoveList<LEGAL> itr (pos); *itr; ++itr)
             {
                 Move m = *itr;
-                pos.do_move (m, si, pos.gives_check (m, ci) ? &ci : NULL);
-                leaf_count += leaf ? MoveList<LEGAL> (pos).size () : _perft (pos, depth - ONE_MOVE);
-                pos.undo_move ();
+                Position &cpos = make_move (pos, m, si, pos.gives_check (m, ci) ? &ci : NULL, ss);
+                leaf_count += leaf ? MoveList<LEGAL> (cpos).size () : _perft (cpos, ss+1, depth - ONE_MOVE);
+                unmake_move (pos, cpos);
             }
 
             return leaf_count;
@@ -315,6 +349,11 @@ namespace Searcher {
             (ss)->ply = (ss-1)->ply + 1;
             (ss)->current_move = MOVE_NONE;
 
+            if (Threadpool.deterministic)
+            {
+                pos.thread ()->check_turn ();
+            }
+
             // Check for an instant draw or maximum ply reached
             if (pos.draw () || ((ss)->ply > MAX_PLY))
             {
@@ -366,6 +405,10 @@ namespace Searcher {
 
             Value futility_base;
 
+            // Static evaluation stored in TT
+            Value tt_eval  = VALUE_NONE;
+            bool lazy_eval = false;
+
             // Evaluate the position statically
             if (IN_CHECK)
             {
@@ -378,7 +421,7 @@ namespace Searcher {
                 {
                     // Never assume anything on values stored in TT
                     Value eval_ = tte->eval ();
-                    if (VALUE_NONE == eval_) eval_ = evaluate (pos);
+                    if (VALUE_NONE == eval_) eval_ = evaluate (pos, alpha, beta, &lazy_eval);
                     best_value = (ss)->static_eval = eval_;
 
                     // Can tt_value be used as a better position evaluation?
@@ -392,8 +435,10 @@ namespace Searcher {
                 }
                 else
                 {
-                    best_value = (ss)->static_eval = evaluate (pos);
+                    best_value = (ss)->static_eval = evaluate (pos, alpha, beta, &lazy_eval);
                 }
+                // A lazy evaluation only bounds the static value, keep it out of the TT
+                tt_eval = lazy_eval ? VALUE_NONE : (ss)->static_eval;
 
                 // Stand pat. Return immediately if static value is at least beta
                 if (best_value >= beta)
@@ -407,7 +452,7 @@ namespace Searcher {
                             BND_LOWER,
                             pos.game_nodes (),
                             value_to_tt (best_value, (ss)->ply),
-                            (ss)->static_eval);
+                            tt_eval);
                     }
 
                     ASSERT (-VALUE_INFINITE < best_value && best_value < +VALUE_INFINITE);
@@ -501,13 +546,13 @@ namespace Searcher {
                 (ss)->current_move = move;
 
                 // Make and search the move
-                pos.do_move (move, si, gives_check ? &ci : NULL);
+                Position &cpos = make_move (pos, move, si, gives_check ? &ci : NULL, ss);
 
                 Value value = gives_check
-                    ? -search_quien<NT, true > (pos, ss+1, -beta, -alpha, depth - ONE_MOVE)
-                    : -search_quien<NT, false> (pos, ss+1, -beta, -alpha, depth - ONE_MOVE);
+                    ? -search_quien<NT, true > (cpos, ss+1, -beta, -alpha, depth - ONE_MOVE)
+                    : -search_quien<NT, false> (cpos, ss+1, -beta, -alpha, depth - ONE_MOVE);
 
-                pos.undo_move ();
+                unmake_move (pos, cpos);
 
                 ASSERT (-VALUE_INFINITE < value && value < +VALUE_INFINITE);
 
@@ -532,7 +577,7 @@ namespace Searcher {
                                 BND_LOWER,
                                 pos.game_nodes (),
                                 value_to_tt (value, (ss)->ply),
-                                (ss)->static_eval);
+                                tt_eval);
 
                             return value;
                         }
@@ -557,7 +602,7 @@ namespace Searcher {
                 PVNode && (best_value > old_alpha) ? BND_EXACT : BND_UPPER,
                 pos.game_nodes (),
                 value_to_tt (best_value, (ss)->ply),
-                (ss)->static_eval);
+                tt_eval);
 
             ASSERT (-VALUE_INFINITE < best_value && best_value < +VALUE_INFINITE);
             return best_value;
@@ -592,7 +637,12 @@ namespace Searcher {
 
             Value best_value
                 , tt_value
-                , eval;
+                , eval
+                , eval_alpha
+                , eval_beta
+                , tt_eval;  // Static evaluation stored in TT, never a lazy one
+
+            bool  lazy_eval = false;
 
             u08   moves_count
                 , quiets_count;
@@ -622,6 +672,11 @@ namespace Searcher {
                 goto moves_loop;
             }
 
+            if (Threadpool.deterministic)
+            {
+                thread->check_turn ();
+            }
+
             moves_count  = 0;
             quiets_count = 0;
 
@@ -665,6 +720,18 @@ namespace Searcher {
                 {
                     return alpha;
                 }
+
+                // Step 3a. Upcoming repetition. If the side to move can go back to an earlier
+                // position of the tree, it can at least draw.
+                if (   alpha < DrawValue[pos.active ()]
+                    && pos.upcoming_repetition ((ss)->ply))
+                {
+                    alpha = DrawValue[pos.active ()];
+                    if (alpha >= beta)
+                    {
+                        return alpha;
+                    }
+                }
             }
 
             // Step 4. Transposition table lookup
@@ -754,19 +821,35 @@ namespace Searcher {
             // Step 5. Evaluate the position statically and update parent's gain statistics
             if (in_check)
             {
-                eval = (ss)->static_eval = VALUE_NONE;
+                eval = (ss)->static_eval = tt_eval = VALUE_NONE;
                 goto moves_loop;
             }
 
             // Rest of code is skipped when in check
             // -------------------------------------
 
+            // Window of the static evaluation, only non-PV nodes in futility range
+            // can do with a lazy one: far enough above beta (plus futility margin)
+            // or below alpha the exact value does not change the pruning decisions.
+            if (!PVNode && depth < 7 * ONE_MOVE)
+            {
+                eval_alpha = alpha;
+                eval_beta  = beta + futility_margin (depth);
+            }
+            else
+            {
+                eval_alpha = -VALUE_INFINITE;
+                eval_beta  = +VALUE_INFINITE;
+            }
+
             if (tte != NULL)
             {
                 // Never assume anything on values stored in TT
                 Value eval_ = tte->eval ();
-                if (VALUE_NONE == eval_) eval_ = evaluate (pos);
+                if (VALUE_NONE == eval_) eval_ = evaluate (pos, eval_alpha, eval_beta, &lazy_eval);
                 eval = (ss)->static_eval = eval_;
+                // A lazy evaluation only bounds the static value, keep it out of the TT
+                tt_eval = lazy_eval ? VALUE_NONE : eval_;
 
                 // Can tt_value be used as a better position evaluation?
                 if (VALUE_NONE != tt_value)
@@ -779,20 +862,25 @@ namespace Searcher {
             }
             else
             {
-                eval = (ss)->static_eval = evaluate (pos);
+                eval = (ss)->static_eval = evaluate (pos, eval_alpha, eval_beta, &lazy_eval);
+                tt_eval = lazy_eval ? VALUE_NONE : eval;
 
-                TT.store (
-                    posi_key,
-                    MOVE_NONE,
-                    DEPTH_NONE,
-                    BND_NONE,
-                    pos.game_nodes (),
-                    VALUE_NONE,
-                    (ss)->static_eval);
+                if (VALUE_NONE != tt_eval)
+                {
+                    TT.store (
+                        posi_key,
+                        MOVE_NONE,
+                        DEPTH_NONE,
+                        BND_NONE,
+                        pos.game_nodes (),
+                        VALUE_NONE,
+                        tt_eval);
+                }
             }
 
-            // Updates Gains
+            // Updates Gains (not with a lazy evaluation)
             if (   (pos.capture_type () == NONE)
+                && !lazy_eval
                 && ((ss  )->static_eval != VALUE_NONE)
                 && ((ss-1)->static_eval != VALUE_NONE)
                 && ((move = (ss-1)->current_move) != MOVE_NULL)
@@ -930,11 +1018,11 @@ namespace Searcher {
 
                         (ss)->current_move = move;
 
-                        pos.do_move (move, si, pos.gives_check (move, ci) ? &ci : NULL);
+                        Position &cpos = make_move (pos, move, si, pos.gives_check (move, ci) ? &ci : NULL, ss);
 
-                        Value value = -search<NonPV> (pos, ss+1, -rbeta, -(rbeta-1), rdepth, !cut_node);
+                        Value value = -search<NonPV> (cpos, ss+1, -rbeta, -(rbeta-1), rdepth, !cut_node);
 
-                        pos.undo_move ();
+                        unmake_move (pos, cpos);
 
                         if (value >= rbeta)
                         {
@@ -1200,7 +1288,7 @@ namespace Searcher {
                 (ss)->current_move = move;
 
                 // Step 14. Make the move
-                pos.do_move (move, si, gives_check ? &ci : NULL);
+                Position &cpos = make_move (pos, move, si, gives_check ? &ci : NULL, ss);
 
                 bool full_depth_search;
 
@@ -1220,7 +1308,7 @@ namespace Searcher {
                     {
                         (ss)->reduction += ONE_MOVE; // 3 * ONE_PLY / 4; // TODO::
                     }
-                    else if (History[pos[dst_sq (move)]][dst_sq (move)] < VALUE_ZERO)
+                    else if (History[cpos[dst_sq (move)]][dst_sq (move)] < VALUE_ZERO)
                     {
                         (ss)->reduction += ONE_MOVE / 2;
                     }
@@ -1237,13 +1325,13 @@ namespace Searcher {
                         alpha = splitpoint->alpha;
                     }
 
-                    value = -search<NonPV> (pos, ss+1, -(alpha+1), -alpha, red_depth, true);
+                    value = -search<NonPV> (cpos, ss+1, -(alpha+1), -alpha, red_depth, true);
 
                     // Research at intermediate depth if reduction is very high
                     if (value > alpha && (ss)->reduction >= 4 * ONE_MOVE)
                     {
                         Depth inter_depth = max (new_depth - 2 * ONE_MOVE, ONE_MOVE);
-                        value = -search<NonPV> (pos, ss+1, -(alpha+1), -alpha, inter_depth, true);
+                        value = -search<NonPV> (cpos, ss+1, -(alpha+1), -alpha, inter_depth, true);
                     }
 
                     full_depth_search = (value > alpha && (ss)->reduction != DEPTH_ZERO);
@@ -1265,9 +1353,9 @@ namespace Searcher {
                     value =
                         (new_depth < ONE_MOVE)
                         ? (gives_check
-                        ? -search_quien<NonPV, true > (pos, ss+1, -(alpha+1), -alpha, DEPTH_ZERO)
-                        : -search_quien<NonPV, false> (pos, ss+1, -(alpha+1), -alpha, DEPTH_ZERO))
-                        : -search      <NonPV       > (pos, ss+1, -(alpha+1), -alpha, new_depth, !cut_node);
+                        ? -search_quien<NonPV, true > (cpos, ss+1, -(alpha+1), -alpha, DEPTH_ZERO)
+                        : -search_quien<NonPV, false> (cpos, ss+1, -(alpha+1), -alpha, DEPTH_ZERO))
+                        : -search      <NonPV       > (cpos, ss+1, -(alpha+1), -alpha, new_depth, !cut_node);
                 }
 
                 // Principal Variation Search
@@ -1281,14 +1369,14 @@ namespace Searcher {
                         value =
                             (new_depth < ONE_MOVE)
                             ? (gives_check
-                            ? -search_quien<PV, true > (pos, ss+1, -beta, -alpha, DEPTH_ZERO)
-                            : -search_quien<PV, false> (pos, ss+1, -beta, -alpha, DEPTH_ZERO))
-                            : -search      <PV       > (pos, ss+1, -beta, -alpha, new_depth, false);
+                            ? -search_quien<PV, true > (cpos, ss+1, -beta, -alpha, DEPTH_ZERO)
+                            : -search_quien<PV, false> (cpos, ss+1, -beta, -alpha, DEPTH_ZERO))
+                            : -search      <PV       > (cpos, ss+1, -beta, -alpha, new_depth, false);
                     }
                 }
 
                 // Step 17. Undo move
-                pos.undo_move ();
+                unmake_move (pos, cpos);
 
                 ASSERT (-VALUE_INFINITE < value && value < +VALUE_INFINITE);
 
@@ -1418,7 +1506,7 @@ namespace Searcher {
                     best_value >= beta ? BND_LOWER : PVNode && best_move ? BND_EXACT : BND_UPPER,
                     pos.game_nodes (),
                     value_to_tt (best_value, (ss)->ply),
-                    (ss)->static_eval);
+                    tt_eval);
 
                 // Quiet best move:
                 if ((best_value >= beta) && (best_move != MOVE_NONE))
@@ -1458,6 +1546,7 @@ namespace Searcher {
             FollowupMoves.clear ();
 
             BestMoveChanges  = 0.0;
+            RootDepth        = 0;
 
             Value best_value = -VALUE_INFINITE
                 , alpha      = -VALUE_INFINITE
@@ -1583,6 +1672,8 @@ namespace Searcher {
                     }
                 }
 
+                if (!Signals.stop) RootDepth = depth;
+
                 // If skill levels are enabled and time is up, pick a sub-optimal best move
                 if (skill.enabled () && skill.time_to_pick (depth))
                 {
@@ -1647,6 +1738,169 @@ namespace Searcher {
 
         }
 
+        // solve_mate() runs the proof-number solver for "go mate <x>" and,
+        // if the mate is proven, puts the mating line on the first root move.
+        bool solve_mate (Position &pos)
+        {
+            vector<Move> root_moves;
+            for (u08 i = 0; i < RootMoves.size (); ++i)
+            {
+                root_moves.push_back (RootMoves[i].pv[0]);
+            }
+
+            vector<Move> pv;
+            u08 mate = MateSearcher::solve (pos, Limits.mate, root_moves, pv);
+
+            point elapsed = now () - SearchTime;
+            if (elapsed == 0) elapsed = 1;
+
+            const MateSearcher::StatsT &stats = MateSearcher::Stats;
+            sync_cout
+                << "info string Mate solver"
+                << " proven "  << (mate != 0 ? "true" : "false")
+                << " nodes "   << stats.nodes
+                << " time "    << elapsed
+                << " nps "     << stats.nodes * M_SEC / elapsed
+                << " hits "    << (stats.probes != 0 ? stats.hits * 100 / stats.probes : 0) << "%"
+                << " entries " << stats.used << "/" << stats.entries
+                << sync_endl;
+
+            if (mate == 0) return false;
+
+            RootMove &rm = *find (RootMoves.begin (), RootMoves.end (), pv[0]);
+            rm.pv = pv;
+            rm.pv.push_back (MOVE_NONE);
+            rm.value[0] = rm.value[1] = mates_in (2 * mate - 1);
+            rm.insert_pv_into_tt (pos);
+            swap (RootMoves[0], rm);
+
+            sync_cout
+                << "info"
+                << " depth "    << u16 (2 * mate - 1)
+                << " seldepth " << u16 (2 * mate - 1)
+                << " score "    << score_uci (RootMoves[0].value[0])
+                << " time "     << elapsed
+                << " nodes "    << pos.game_nodes ()
+                << " nps "      << pos.game_nodes () * M_SEC / elapsed
+                << " pv";
+            for (u08 j = 0; RootMoves[0].pv[j] != MOVE_NONE; ++j)
+            {
+                cout << " " << move_to_can (RootMoves[0].pv[j], pos.chess960 ());
+            }
+            cout << sync_endl;
+
+            return true;
+        }
+
+        // probe_analysis() looks up the root position in the analysis database.
+        // The stored line is rebuilt following the best moves of the database,
+        // and seeds the TT if asked. Returns true when the stored result is deep
+        // enough to be played without searching.
+        bool probe_analysis (Position &pos)
+        {
+            const AnalysisDB::ADEntry *ade = ADB.probe (pos.posi_key ());
+            if (ade == NULL) return false;
+
+            vector<RootMove>::iterator itr = find (RootMoves.begin (), RootMoves.end (), Move (ade->move));
+            if (itr == RootMoves.end ()) return false;
+
+            RootMove &rm = *itr;
+            Move m = rm.pv[0];
+            rm.pv.clear ();
+
+            u08 ply = 0;
+            StateInfo states[MAX_PLY_6]
+            ,        *si = states;
+
+            const AnalysisDB::ADEntry *next;
+            do
+            {
+                rm.pv.push_back (m);
+                pos.do_move (m, *si++);
+                ++ply;
+                next = ADB.probe (pos.posi_key ());
+            }
+            while (next
+                && (m = Move (next->move)) != MOVE_NONE
+                && pos.pseudo_legal (m)
+                && pos.legal (m)
+                && (ply < MAX_PLY)
+                && (!pos.draw () || ply < 2));
+
+            rm.pv.push_back (MOVE_NONE); // Must be zero-terminating
+
+            do
+            {
+                pos.undo_move ();
+                --ply;
+            }
+            while (ply != 0);
+
+            if (bool (*(Options["Analysis Seed"])))
+            {
+                rm.insert_pv_into_tt (pos);
+            }
+
+            u08 depth = i32 (*(Options["Analysis Depth"]));
+            if (Limits.depth != 0) depth = Limits.depth;
+
+            if (   depth == 0
+                || ade->depth < depth
+                || Limits.infinite
+                || Limits.mate
+                || i32 (*(Options["MultiPV"])) > 1
+                || i32 (*(Options["Skill Level"])) < MAX_SKILL_LEVEL)
+            {
+                return false;
+            }
+
+            rm.value[0] = rm.value[1] = Value (ade->value);
+            swap (RootMoves[0], rm);
+
+            MultiPV = 1;
+            IndexPV = 0;
+            sync_cout
+                << info_pv (pos, ade->depth, -VALUE_INFINITE, +VALUE_INFINITE, now () - SearchTime) << "\n"
+                << "info string Analysis DB depth " << u16 (ade->depth) << " nodes " << ade->nodes
+                << sync_endl;
+
+            return true;
+        }
+
+        // store_analysis() writes the result of the completed search into the analysis
+        // database, the root position and the positions along the PV with the remaining depth.
+        void store_analysis (Position &pos)
+        {
+            const RootMove &rm = RootMoves[0];
+            if (   RootDepth == 0
+                || RootInTB
+                || rm.value[0] == -VALUE_INFINITE
+                || !Limits.searchmoves.empty ()
+                || i32 (*(Options["Skill Level"])) < MAX_SKILL_LEVEL)
+            {
+                return;
+            }
+
+            u08 ply = 0;
+            StateInfo states[MAX_PLY_6]
+            ,        *si = states;
+
+            while (MOVE_NONE != rm.pv[ply] && ply < RootDepth)
+            {
+                // Value from the side to move point of view, mate relative to the position
+                Value value = value_to_tt (rm.value[0], ply);
+                ADB.store (pos.posi_key (), rm.pv[ply], (ply % 2) ? -value : value, RootDepth - ply, ply == 0 ? pos.game_nodes () : 0);
+
+                pos.do_move (rm.pv[ply++], *si++);
+            }
+
+            while (ply != 0)
+            {
+                pos.undo_move ();
+                --ply;
+            }
+        }
+
     } // namespace
 
     LimitsT             Limits;
@@ -1746,7 +2000,11 @@ namespace Searcher {
 
     u64 perft (Position &pos, const Depth &depth)
     {
-        return (depth > ONE_MOVE) ? _perft (pos, depth) : MoveList<LEGAL> (pos).size ();
+        // Only the plies of the stack are used (per-ply stack of the copy-make)
+        Stack stack[MAX_PLY_6];
+        for (u08 i = 0; i < MAX_PLY_6; ++i) stack[i].ply = i;
+
+        return (depth > ONE_MOVE) ? _perft (pos, stack, depth) : MoveList<LEGAL> (pos).size ();
     }
 
     void think ()
@@ -1870,14 +2128,43 @@ namespace Searcher {
         // Reset the threads, still sleeping: will wake up at split time
         for (u08 t = 0; t < Threadpool.size (); ++t)
         {
-            Threadpool[t]->max_ply = 0;
+            Threadpool[t]->max_ply    = 0;
+            Threadpool[t]->has_turn   = false;
+            Threadpool[t]->turn_nodes = 0;
+            Threadpool[t]->repetitions.clear ();
         }
+        // The path of the root (since the last irreversible move) for the repetitions
+        RootPos.count_path (true);
+
+        // Main thread starts with the turn
+        Threadpool.deterministic = *(Options["Deterministic Search"]);
+        Threadpool.runnable.reset ();
+        Threadpool.runnable.set (RootPos.thread ()->idx);
+        RootPos.thread ()->has_turn = true;
 
         Threadpool.idle_sleep = *(Options["Idle Threads Sleep"]);
         Threadpool.timer->run = true;
 
         Threadpool.timer->notify_one ();// Wake up the recurring timer
-        iter_deep_loop (RootPos);       // Let's start searching !
+
+        if (bool (*(Options["Analysis DB"])) && !ADB.is_open ())
+        {
+            string analysis_fn = string (*(Options["Analysis File"]));
+            if (!ADB.open (analysis_fn, i32 (*(Options["Analysis Size"]))))
+            {
+                sync_cout << "info string Analysis DB \'" << analysis_fn << "\' not opened." << sync_endl;
+            }
+        }
+
+        // Mate search tries the proof-number solver first, then the analysis database
+        // may answer from an earlier search, otherwise falls back to the normal search.
+        if (   (!Limits.mate    || !solve_mate (RootPos))
+            && (!ADB.is_open () || !probe_analysis (RootPos)))
+        {
+            iter_deep_loop (RootPos);   // Let's start searching !
+
+            if (ADB.is_open ()) store_analysis (RootPos);
+        }
 
         Threadpool.timer->run = false;  // Stop the timer
         Threadpool.idle_sleep = true;   // Send idle threads to sleep
@@ -2114,10 +2401,16 @@ namespace Threads {
                     , *ss = stack+2; // To allow referencing (ss-2)
 
                 Position pos (*(sp)->pos, this);
+                pos.count_path (true);
 
                 memcpy (ss-2, (sp)->ss-2, 5 * sizeof (Stack));
                 (ss)->splitpoint = sp;
 
+                if (Threadpool.deterministic)
+                {
+                    wait_turn ();
+                }
+
                 // Lock splitpoint
                 (sp)->mutex.lock ();
 
@@ -2135,11 +2428,29 @@ namespace Threads {
 
                 ASSERT (searching);
 
+                pos.count_path (false);
+
                 searching  = false;
                 active_pos = NULL;
                 (sp)->slaves_mask.reset (idx);
                 (sp)->nodes += pos.game_nodes ();
 
+                // Stay runnable only as a master whose own splitpoint is finished,
+                // the last slave of a splitpoint makes its master runnable.
+                bool turn_passed = false;
+                if (Threadpool.deterministic)
+                {
+                    if ((sp)->slaves_mask.none ())
+                    {
+                        Threadpool.runnable.set ((sp)->master->idx);
+                    }
+                    if (splitpoint == NULL || splitpoint->slaves_mask.any ())
+                    {
+                        Threadpool.runnable.reset (idx);
+                        turn_passed = true;
+                    }
+                }
+
                 // Wake up master thread so to allow it to return from the idle loop
                 // in case we are the last slave of the splitpoint.
                 if (   Threadpool.idle_sleep
@@ -2155,6 +2466,11 @@ namespace Threads {
                 // our feet by the sp master. Also accessing other Thread objects is
                 // unsafe because if we are exiting there is a chance are already freed.
                 (sp)->mutex.unlock ();
+
+                if (turn_passed)
+                {
+                    pass_turn ();
+                }
             }
 
             // If this thread is the master of a splitpoint and all slaves have finished
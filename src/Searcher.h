@@ -22,7 +22,7 @@ namespace Threads {
     struct SplitPoint;
 }
 
-typedef std::auto_ptr<StateInfoStack>       StateInfoStackPtr;
+typedef std::shared_ptr<StateInfoStack>     StateInfoStackPtr;
 
 namespace Searcher {
 
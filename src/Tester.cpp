@@ -181,7 +181,7 @@ namespace Tester {
         void test_fen ()
         {
             const char *fen;
-            char buf[FEN_LEN];
+            char buf[FEN_LEN + 1];
             Position pos (0);
             Square s;
 
@@ -75,8 +75,33 @@ namespace Threads {
         , active_splitpoint (NULL)
         , splitpoint_threads (0)
         , searching (false)
+        , has_turn (false)
+        , turn_nodes (0)
     {}
 
+    // pass_turn() gives the turn to the next runnable thread in index order,
+    // the thread keeps the turn if it is the only runnable one.
+    void Thread::pass_turn ()
+    {
+        ASSERT (has_turn);
+
+        u08 threads = Threadpool.size ();
+        for (u08 i = 1; i <= threads; ++i)
+        {
+            Thread *th = Threadpool[(idx + i) % threads];
+            if (Threadpool.runnable.test (th->idx))
+            {
+                if (th != this)
+                {
+                    has_turn = false;
+                    th->has_turn = true;
+                    th->notify_one ();
+                }
+                return;
+            }
+        }
+    }
+
     // cutoff_occurred() checks whether a beta cutoff has occurred in the
     // current active splitpoint, or in some ancestor of the splitpoint.
     bool Thread::cutoff_occurred () const
@@ -161,6 +186,10 @@ namespace Threads {
             while ((slave = Threadpool.available_slave (this)) != NULL)
             {
                 sp.slaves_mask.set (slave->idx);
+                if (Threadpool.deterministic)
+                {
+                    Threadpool.runnable.set (slave->idx);
+                }
                 slave->active_splitpoint = &sp;
                 slave->searching = true;        // Leaves idle_loop()
                 slave->notify_one ();           // Notifies could be sleeping
@@ -176,6 +205,12 @@ namespace Threads {
 
         Thread::idle_loop (); // Force a call to base class Thread::idle_loop()
 
+        // Last slave made the master runnable, wait to get back the turn
+        if (Threadpool.deterministic)
+        {
+            wait_turn ();
+        }
+
         // In helpful master concept a master can help only a sub-tree of its splitpoint,
         // and because here is all finished is not possible master is booked.
         ASSERT (!searching);
@@ -261,10 +296,11 @@ namespace Threads {
     // initialize() is called at startup to create and launch requested threads, that will
     // go immediately to sleep due to 'idle_sleep' set to true.
     // We cannot use a c'tor becuase Threadpool is a static object and we need a fully initialized
-    // engine at this point due to allocation of Endgames in Thread c'tor.
+    // engine at this point due to allocation of the tables in Thread c'tor.
     void ThreadPool::initialize ()
     {
         idle_sleep = true;
+        deterministic = false;
         timer = new_thread<TimerThread> ();
         push_back (new_thread<MainThread> ());
         configure ();
@@ -311,9 +347,16 @@ namespace Threads {
             pop_back ();
         }
 
+        u32 eval_cache = i32 (*(Options["Eval Cache"]));
+        for (iterator itr = begin (); itr != end (); ++itr)
+        {
+            (*itr)->eval_cache.resize (eval_cache);
+        }
+
         sync_cout
             << "info string Thread(s) "   << u16 (threads) << ".\n"
-            << "info string Split Depth " << split_depth << sync_endl;
+            << "info string Split Depth " << split_depth << "\n"
+            << "info string Eval Cache "  << eval_cache << " KB..." << sync_endl;
 
     }
 
@@ -345,8 +388,9 @@ namespace Threads {
         Limits      = limits;
         if (states.get () != NULL) // If we don't set a new position, preserve current state
         {
-            SetupStates = states;   // Ownership transfer here
-            ASSERT (states.get () == NULL);
+            // Ownership is shared, the caller may extend the same states
+            // with the next moves of the game
+            SetupStates = states;
         }
         
         RootMoves.clear ();
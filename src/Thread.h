@@ -11,6 +11,7 @@
 #include "Position.h"
 #include "Pawns.h"
 #include "Material.h"
+#include "Evaluator.h"
 #include "MovePicker.h"
 #include "Searcher.h"
 
@@ -83,6 +84,7 @@ namespace Threads {
     const u08   MAX_THREADS            = 128; // Maximum threads
     const u08   MAX_SPLITPOINT_THREADS =   8; // Maximum threads per splitpoint
     const u08   MAX_SPLIT_DEPTH        =  15; // Maximum split depth
+    const u16   TURN_QUANTUM           = 1024;// Nodes searched before passing the turn (deterministic search)
 
     extern void timed_wait (WaitCondition &sleep_cond, Lock &sleep_lock, i32 msec);
 
@@ -208,7 +210,14 @@ namespace Threads {
         
         Material::Table   material_table;
         Pawns   ::Table   pawns_table;
-        EndGame::Endgames endgames;
+        Evaluator::Cache  eval_cache;
+        Evaluator::LazyStats lazy_stats;
+        RepetitionTable   repetitions;
+
+#ifdef COPYMAKE
+        // Per-ply stack of the copy-make search, the moves of the ply are made on [ply + 1]
+        Position  ply_positions[MAX_PLY_6];
+#endif
 
         Position *active_pos;
         u08   idx
@@ -218,10 +227,27 @@ namespace Threads {
         volatile u08  splitpoint_threads;
         volatile bool searching;
 
+        // Deterministic search: only the thread holding the turn runs,
+        // the turn is passed in a fixed order every TURN_QUANTUM nodes.
+        volatile bool has_turn;
+        u16           turn_nodes;
+
         Thread ();
 
         virtual void idle_loop ();
 
+        void wait_turn () { wait_for (has_turn); }
+        void pass_turn ();
+        void check_turn ()
+        {
+            if (++turn_nodes >= TURN_QUANTUM)
+            {
+                turn_nodes = 0;
+                pass_turn ();
+                wait_turn ();
+            }
+        }
+
         bool cutoff_occurred () const;
 
         bool available_to (const Thread *master) const;
@@ -262,6 +288,11 @@ namespace Threads {
         Depth   split_depth;
         Mutex   mutex;
 
+        // Deterministic search: threads which can take the turn, updated only
+        // by the thread holding the turn, so the schedule never depends on timing.
+        bool    deterministic;
+        std::bitset<MAX_THREADS> runnable;
+
         Condition   sleep_condition;
         TimerThread *timer;
 
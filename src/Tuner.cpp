@@ -0,0 +1,241 @@
+#include "Tuner.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "Position.h"
+#include "PositionStream.h"
+#include "Evaluator.h"
+#include "Thread.h"
+#include "UCI.h"
+
+namespace Tuner {
+
+    using namespace std;
+    using namespace Threads;
+
+    namespace {
+
+        // Evaluation weight options which are tuned, all in [0, 200] percent.
+        // 'Space' is the same option for the midgame and the endgame.
+        // 'Cowardice' and 'Aggressive' are not tuned: they weight the king danger
+        // by the side of the root of the search, not by the side of the position,
+        // so the static evaluation of the dataset cannot tell them apart.
+        const char *WeightOptions[] =
+        {
+            "Mobility (Midgame)"      , "Mobility (Endgame)",
+            "Pawn Structure (Midgame)", "Pawn Structure (Endgame)",
+            "Passed Pawns (Midgame)"  , "Passed Pawns (Endgame)",
+            "Space",
+        };
+
+        const u08 WEIGHT_OPTIONS = sizeof (WeightOptions) / sizeof (*WeightOptions);
+
+        const i32 MIN_WEIGHT = 0
+            ,     MAX_WEIGHT = 200;
+
+        vector<PackedPosition> Positions;
+        vector<double>         Results; // Game results from white point of view
+        vector<Value>          Values;  // Evaluations from side to move point of view
+        u64                    Skipped; // Lines with an invalid position or no result
+
+        // read_result() finds the game result in the line, the FEN fields cannot hold one
+        bool read_result (const char *line, double &result)
+        {
+            if      (strstr (line, "1/2-1/2") != NULL || strstr (line, "[0.5]") != NULL) result = 0.5;
+            else if (strstr (line, "1-0")     != NULL || strstr (line, "[1.0]") != NULL) result = 1.0;
+            else if (strstr (line, "0-1")     != NULL || strstr (line, "[0.0]") != NULL) result = 0.0;
+            else return false;
+            return true;
+        }
+
+        // load() reads the dataset and packs its positions
+        u64 load (const string &fn, bool c960)
+        {
+            Positions.clear ();
+            Results.clear ();
+            Skipped = 0;
+
+            FenReader fr (fn);
+            if (!fr.is_open ()) return 0;
+
+            Position pos (0);
+            PackedPosition pp;
+            // Piece placement, active color, castling and en-passant fields
+            while (fr.read (pos, Threadpool.main (), c960, false))
+            {
+                double result;
+                if (!read_result (fr.line (), result))
+                {
+                    ++Skipped;
+                    continue;
+                }
+
+                pos.pack (pp);
+                Positions.push_back (pp);
+                Results.push_back (result);
+            }
+
+            Skipped += fr.skipped ();
+            Values.resize (Positions.size ());
+            return Positions.size ();
+        }
+
+        // evaluate() evaluates all the positions in parallel with the current weights
+        void evaluate (bool c960)
+        {
+            Evaluator::evaluate_batch (&Positions[0], Positions.size (), &Values[0], NULL, c960);
+        }
+
+        // error() is the mean squared error between the results and the expected
+        // scores given by the logistic of the evaluations (scaled by 'k').
+        // Positions in check have no evaluation and are left out.
+        double error (double k)
+        {
+            double sum = 0.0;
+            u64    count = 0;
+            for (u64 i = 0; i < Positions.size (); ++i)
+            {
+                if (VALUE_NONE == Values[i]) continue;
+
+                double cp = 100.0 * i32 (WHITE == Positions[i].active ? Values[i] : -Values[i]) / i32 (VALUE_MG_PAWN);
+                double expected = 1.0 / (1.0 + pow (10.0, -k * cp / 400.0));
+                sum += (Results[i] - expected) * (Results[i] - expected);
+                ++count;
+            }
+            return count != 0 ? sum / count : 0.0;
+        }
+
+        // best_k() finds the scaling constant which best fits the current evaluations,
+        // a coarse scan followed by a fine one around the best coarse value.
+        double best_k ()
+        {
+            double k = 1.0;
+            double e = error (k);
+            for (double step = 0.1; step >= 0.001; step /= 10)
+            {
+                double base = k;
+                for (i32 i = -10; i <= 10; ++i)
+                {
+                    double ki = base + i * step;
+                    if (ki <= 0.0) continue;
+                    double ei = error (ki);
+                    if (ei < e)
+                    {
+                        e = ei;
+                        k = ki;
+                    }
+                }
+            }
+            return k;
+        }
+
+        inline i32 weight (u08 i)
+        {
+            return i32 (*(Options[WeightOptions[i]]));
+        }
+
+        // set_weight() sets the option which also recomputes the weights
+        // and clears the evaluation caches.
+        inline void set_weight (u08 i, i32 value)
+        {
+            ostringstream oss;
+            oss << value;
+            string str = oss.str ();
+            *(Options[WeightOptions[i]]) = str;
+        }
+
+    }
+
+    void tune (istream &is)
+    {
+        string fn, token;
+        if (!(is >> fn))
+        {
+            cerr << "ERROR: No dataset for tuning..." << endl;
+            return;
+        }
+        u32    iterations = (is >> token) ? abs (atoi (token.c_str ())) : 100;
+        string out_fn     = (is >> token) ? token : "";
+
+        bool c960 = bool (*(Options["UCI_Chess960"]));
+
+        u64 count = load (fn, c960);
+        if (count == 0)
+        {
+            cerr << "ERROR: No position loaded from \'" << fn << "\'" << endl;
+            return;
+        }
+
+        evaluate (c960);
+        double k    = best_k ();
+        double best = error (k);
+
+        cerr
+            << "Positions : " << count << "\n"
+            << "Skipped   : " << Skipped << "\n"
+            << "Threads   : " << u16 (Threadpool.size ()) << "\n"
+            << "K         : " << k << "\n"
+            << "Error     : " << best << endl;
+
+        // Local search: every weight is moved by the step in both directions and kept
+        // if the error decreases, the step is halved when no weight moved.
+        i32 step = 8;
+        for (u32 iter = 1; iter <= iterations && step > 0; ++iter)
+        {
+            bool improved = false;
+            for (u08 i = 0; i < WEIGHT_OPTIONS; ++i)
+            {
+                i32 value = weight (i);
+                for (i32 dir = +1; dir >= -1; dir -= 2)
+                {
+                    i32 v = value + dir * step;
+                    if (v < MIN_WEIGHT || MAX_WEIGHT < v) continue;
+
+                    set_weight (i, v);
+                    evaluate (c960);
+                    double e = error (k);
+                    if (e < best)
+                    {
+                        best  = e;
+                        value = v;
+                        improved = true;
+                        break;
+                    }
+                }
+                set_weight (i, value);
+            }
+
+            cerr << "Iteration " << iter << " step " << step << " error " << best << endl;
+
+            if (!improved) step /= 2;
+        }
+
+        ostringstream oss;
+        for (u08 i = 0; i < WEIGHT_OPTIONS; ++i)
+        {
+            oss << (i != 0 ? "\n" : "") << "setoption name " << WeightOptions[i] << " value " << weight (i);
+        }
+
+        sync_cout << oss.str () << sync_endl;
+        if (!out_fn.empty ())
+        {
+            ofstream ofs (out_fn);
+            if (ofs.is_open ())
+            {
+                ofs << oss.str () << endl;
+                ofs.close ();
+            }
+            else
+            {
+                cerr << "ERROR: Unable to write file ... \'" << out_fn << "\'" << endl;
+            }
+        }
+    }
+
+}
@@ -0,0 +1,27 @@
+#ifdef _MSC_VER
+#   pragma once
+#endif
+
+#ifndef _TUNER_H_INC_
+#define _TUNER_H_INC_
+
+#include <iosfwd>
+
+// Tuner is a Texel-style tuner of the evaluation weights.
+// It minimizes the mean squared error between the game results of a dataset
+// and the logistic of the static evaluation of its positions, by local search
+// over the evaluation weight options (the Score weights of the evaluation).
+namespace Tuner {
+
+    // tune() runs the "tune" command:
+    //  - dataset filename, one position per line: FEN followed by the game result
+    //    as "1-0", "0-1", "1/2-1/2" or "[1.0]", "[0.0]", "[0.5]" (EPD opcodes ignored)
+    //  - number of iterations over all the weights (default is 100)
+    //  - filename where to write the tuned weights (default is none)
+    // The tuned weights are set on the options and printed as "setoption" commands.
+    // example: tune quiet-labeled.epd 50 tuned.txt
+    extern void tune (std::istream &is);
+
+}
+
+#endif // _TUNER_H_INC_
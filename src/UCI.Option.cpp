@@ -7,10 +7,13 @@
 
 #include "Transposition.h"
 #include "Evaluator.h"
+#include "Network.h"
 #include "Searcher.h"
 #include "Thread.h"
 #include "Debugger.h"
 #include "TB_Syzygy.h"
+#include "MateSearcher.h"
+#include "AnalysisDB.h"
 
 UCI::OptionMap  Options; // Global string mapping of Options
 
@@ -212,6 +215,10 @@ namespace UCI {
         void on_clear_hash  (const Option &)
         {
             TT.master_clear ();
+            for (u08 t = 0; t < Threadpool.size (); ++t)
+            {
+                Threadpool[t]->eval_cache.clear ();
+            }
         }
 
         void on_resize_hash (const Option &opt)
@@ -219,6 +226,11 @@ namespace UCI {
             TT.resize (i32 (opt), false);
         }
 
+        void on_resize_mate_hash (const Option &opt)
+        {
+            MateSearcher::resize (i32 (opt));
+        }
+
         void on_save_hash   (const Option &)
         {
             string hash_fn = string (*(Options["Hash File"]));
@@ -242,6 +254,11 @@ namespace UCI {
             Searcher::Book.close ();
         }
 
+        void on_change_analysis (const Option &)
+        {
+            ADB.close ();
+        }
+
         void on_change_tb_syzygy (const Option &opt)
         {
             string syzygy_path = string (opt);
@@ -256,6 +273,21 @@ namespace UCI {
         void on_change_evaluation(const Option &)
         {
             Evaluator::initialize ();
+            // Cached evaluations are no longer valid
+            for (u08 t = 0; t < Threadpool.size (); ++t)
+            {
+                Threadpool[t]->eval_cache.clear ();
+            }
+        }
+
+        void on_change_network   (const Option &)
+        {
+            Network::initialize ();
+            // Cached evaluations are no longer valid
+            for (u08 t = 0; t < Threadpool.size (); ++t)
+            {
+                Threadpool[t]->eval_cache.clear ();
+            }
         }
 
         void on_force_null_move  (const Option &opt)
@@ -360,6 +392,19 @@ namespace UCI {
         // Position Learning Options
         // -------------------------
 
+        // Whether or not the engine should use the Analysis Database.
+        // The results of completed searches are kept on disk and reused in later sessions.
+        Options["Analysis DB"]                  = OptionPtr (new CheckOption (false, on_change_analysis));
+        // The filename of the Analysis Database.
+        Options["Analysis File"]                = OptionPtr (new StringOption ("Analysis.adb", on_change_analysis));
+        // The size in MB of a new Analysis Database, an existing file keeps its own size.
+        Options["Analysis Size"]                = OptionPtr (new SpinOption ( 16, 1, 4096));
+        // Minimum stored depth to play the move of the Analysis Database without searching.
+        // Default 0 means never, the stored line then only seeds the search.
+        Options["Analysis Depth"]               = OptionPtr (new SpinOption (  0, 0, MAX_PLY));
+        // Whether or not to seed the Transposition Table with the line of the Analysis Database.
+        Options["Analysis Seed"]                = OptionPtr (new CheckOption (true));
+
         // Openings Book Options
         // ---------------------
         // Whether or not the engine should use the Opening Book.
@@ -398,6 +443,14 @@ namespace UCI {
         // The default value 10 is tuned for Intel quad-core i5/i7 systems, but on other systems it may be advantageous to increase this to 12 or 14.
         Options["Split Depth"]                  = OptionPtr (new SpinOption ( 0, 0, MAX_SPLIT_DEPTH, on_config_threadpool));
 
+        // The size in KB of the evaluation cache of each thread.
+        // Default 0, Min 0, Max 16384.
+        //
+        // The evaluation of a position is kept by its key, so it is not computed again when the position
+        // is reached again (quiescence search, next iterations). Value 0 disables the cache.
+        // Off by default, the transposition table already keeps the evaluation of most positions.
+        Options["Eval Cache"]                   = OptionPtr (new SpinOption (  0, 0, 16384, on_config_threadpool));
+
         // If this is set to true, threads are suspended when there is no work to do.
         // This saves CPU power consumption, but waking a thread takes a small bit of time.
         // For maximum performance, set this option to false,
@@ -405,6 +458,14 @@ namespace UCI {
         // Default true
         Options["Idle Threads Sleep"]           = OptionPtr (new CheckOption (true));
 
+        // If this is set to true, the threads search in turns following a fixed schedule
+        // (every thread passes the turn after a fixed number of nodes), so a multi-threaded
+        // search gives the same nodes, score and best move on every run.
+        // Only one thread runs at a time, so this is meant for reproducible benchmarks and
+        // for debugging the parallel search, not for playing.
+        // Default false
+        Options["Deterministic Search"]         = OptionPtr (new CheckOption (false));
+
         // Game Play Options
         // -----------------
 
@@ -507,6 +568,21 @@ namespace UCI {
         Options["Cowardice"]                    = OptionPtr (new SpinOption (100, 0, 200, on_change_evaluation));
         // Degree of agressiveness.
         Options["Aggressive"]                   = OptionPtr (new SpinOption (100, 0, 200, on_change_evaluation));
+        // Margin in centipawns of the lazy evaluation.
+        // Default 0, Min 0, Max 2000.
+        //
+        // When material, piece-square and pawn structure alone are more than this margin
+        // outside of the search window, the rest of the evaluation is skipped. Value 0 disables it.
+        // A lazy value is less exact, the faster evaluation may cost a larger tree.
+        Options["Lazy Margin"]                  = OptionPtr (new SpinOption (0, 0, 2000, on_change_evaluation));
+        // Whether or not to evaluate with the neural network instead of the hand-written terms.
+        // Default false.
+        //
+        // The network is loaded from the Network File, if it can not be loaded the classical evaluation is kept.
+        // The weight options above then have no effect.
+        Options["Use Network"]                  = OptionPtr (new CheckOption (false, on_change_network));
+        // The filename of the network (768 -> 2x256 -> 1, raw 16-bit weights).
+        Options["Network File"]                 = OptionPtr (new StringOption ("Network.bin", on_change_network));
 
 
         // TODO::
@@ -517,6 +593,12 @@ namespace UCI {
         // If you know that a position is "mate in <x>", you can use <x> or a value slightly larger than <x> in the Mate Search option.
         // This will prevent DON from going too deep in variations that don't lead to mate in the required number of moves.
         Options["Mate Search"]                  = OptionPtr (new SpinOption (  0, 0, 99));
+        // The amount of memory in MB the proof-number solver uses for "go mate <x>".
+        // Default 16, Min 1, Max 1024.
+        //
+        // The solver keeps proof and disproof numbers in its own table, separate from the main Hash.
+        // Longer mates need a bigger table, when the table is full old entries are replaced and solved again.
+        Options["Mate Hash"]                    = OptionPtr (new SpinOption ( 16, 1, 1024, on_resize_mate_hash));
         // How well you want engine to play.
         // At level 0, engine will make dumb moves. MAX_SKILL_LEVEL is best/strongest play.
         Options["Skill Level"]                  = OptionPtr (new SpinOption (MAX_SKILL_LEVEL,  0, MAX_SKILL_LEVEL));
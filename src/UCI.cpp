@@ -8,6 +8,7 @@
 #include "Searcher.h"
 #include "Evaluator.h"
 #include "Benchmark.h"
+#include "Tuner.h"
 #include "Notation.h"
 #include "Thread.h"
 #include "Debugger.h"
@@ -33,6 +34,13 @@ namespace UCI {
         // Needed by repetition draw detection.
         StateInfoStackPtr SetupStates;
 
+        // FEN and moves of the last "position" command.
+        // GUI sends the whole game on every move, so when the new command
+        // just extends the last one, only the new moves need to be done.
+        string          SetupFen;
+        bool            SetupC960;
+        vector<string>  SetupMoves;
+
 
         inline void exe_uci ()
         {
@@ -45,7 +53,13 @@ namespace UCI {
 
         inline void exe_ucinewgame ()
         {
+            SetupFen.clear ();
+            SetupMoves.clear ();
             TT.clear_hash = !bool (*(Options["Never Clear Hash"]));
+            for (u08 t = 0; t < Threadpool.size (); ++t)
+            {
+                Threadpool[t]->eval_cache.clear ();
+            }
         }
 
         inline void exe_isready ()
@@ -167,35 +181,68 @@ namespace UCI {
                 else return;
             }
             else return;
-            
-            Key posi_key = RootPos.posi_key ();
 
-            RootPos.setup (fen, Threadpool.main (), bool (*(Options["UCI_Chess960"])));
-            
-            if (posi_key != RootPos.posi_key ())
+            vector<string> moves;
+            if (token == "moves")
+            {
+                while (cstm >> token)
+                {
+                    moves.push_back (token);
+                }
+            }
+
+            bool c960 = bool (*(Options["UCI_Chess960"]));
+
+            // Same game with more moves, keep the states and continue from the last position
+            u32 done_moves = 0;
+            if (   SetupStates.get () != NULL
+                && fen  == SetupFen
+                && c960 == SetupC960
+                && moves.size () >= SetupMoves.size ()
+                && equal (SetupMoves.begin (), SetupMoves.end (), moves.begin ()))
             {
-                TT.clear ();
+                done_moves = SetupMoves.size ();
             }
+            else
+            {
+                // Reject a malformed fen before touching the root position
+                Position pos (0);
+                if (!pos.setup (fen, Threadpool.main (), c960))
+                {
+                    cerr << "ERROR: Invalid FEN '" << fen << "'" << endl;
+                    return;
+                }
+
+                Key posi_key = RootPos.posi_key ();
 
-            SetupStates = StateInfoStackPtr (new StateInfoStack ());
+                RootPos = pos;
+
+                if (posi_key != RootPos.posi_key ())
+                {
+                    TT.clear ();
+                }
+
+                SetupStates = StateInfoStackPtr (new StateInfoStack ());
+                SetupFen    = fen;
+                SetupC960   = c960;
+                SetupMoves.clear ();
+            }
 
             // parse and validate game moves (if any)
-            if (token == "moves")
+            for (u32 i = done_moves; i < moves.size (); ++i)
             {
-                while (cstm >> token)
+                Move m = move_from_can (moves[i], RootPos);
+
+                if (MOVE_NONE == m)
                 {
-                    Move m = move_from_can (token, RootPos);
-                    
-                    if (MOVE_NONE == m)
-                    {
-                        cerr << "ERROR: Illegal Move '" + token << "'" << endl;
-                        break;
-                    }
-                    
-                    SetupStates->push (StateInfo ());
-                    
-                    RootPos.do_move (m, SetupStates->top ());
+                    cerr << "ERROR: Illegal Move '" + moves[i] << "'" << endl;
+                    break;
                 }
+
+                SetupStates->push (StateInfo ());
+
+                RootPos.do_move (m, SetupStates->top ());
+                SetupMoves.push_back (moves[i]);
             }
         }
 
@@ -350,6 +397,7 @@ namespace UCI {
 
         inline void exe_flip ()
         {
+            SetupFen.clear ();
             RootPos.flip ();
         }
 
@@ -427,6 +475,7 @@ namespace UCI {
             else if (token == "eval")       exe_eval ();
             else if (token == "perft")      exe_perft (cstm);
             else if (token == "bench")      benchmark (cstm, RootPos);
+            else if (token == "tune")       Tuner::tune (cstm);
             else if (token == "stop"
                 ||   token == "quit")       exe_stop ();
             else
@@ -11,7 +11,9 @@ namespace Zobrist {
     using namespace std;
     using namespace BitBoard;
 
-    RKISS   Rkiss;
+    // Fixed seed: the exclusion key must be the same on every run,
+    // else the search (and the node count of 'bench') is not reproducible.
+    RKISS   Rkiss (73);
     Key     Exclusion;
 
     void Zob::initialize (RKISS rk)